@@ -1,6 +1,7 @@
 #!/bin/bash
 
 cp ~/mini-ndn/examples/svs.py .
+cp ~/mini-ndn/examples/evstore.py .
 
 rm -rf svs
 mkdir svs
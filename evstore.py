@@ -0,0 +1,204 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Columnar store of experiment results.
+#
+# write_run() packs everything a run of svs.py leaves in its log
+# directory -- each node's event log (the binary <node>.bin if there is
+# one, otherwise the text <node>.log) and the NFD status reports taken
+# before and after the run -- into one Parquet file with a row per
+# event:
+#
+#   protocol    str    e.g. "svs" (dictionary encoded, as are node,
+#                      event and name)
+#   pub_timing  int32
+#   run         int32
+#   node        str    the node that logged the event
+#   event       str    PUBL_MSG, RECV_STATE, SEND_SYNC_INT, ... or
+#                      NFD_STATUS_START / NFD_STATUS_END
+#   name        str    the publishing node of PUBL_MSG / RECV_STATE,
+#                      the counter of NFD_STATUS_*
+#   seq         int64  sequence number of PUBL_MSG / RECV_STATE
+#   ns          int64  steady clock ns (shared by the nodes of a run)
+#   value       int64  publish to receive latency in ns of RECV_STATE
+#                      (if known), the counter's value of NFD_STATUS_*
+#   phase       str    the phase the node was in when it logged the
+#                      event (WARMUP, MEASURE, DRAIN, see Phases in
+#                      log.hpp), null before the node's first
+#                      publication and in logs without PHASE events.
+#                      PHASE events have the phase starting as name.
+#
+# Columns that don't apply to an event are null. load() scans the
+# files of many runs as one table.
+
+import csv
+import glob
+import os
+import struct
+from datetime import datetime
+
+EVLOG_MAGIC = b'EVLOG01\n'
+EVLOG_HEADER = struct.Struct('<8sQQiI')
+EVLOG_RECORD = struct.Struct('<QQQIHH')
+EVLOG_TYPES = {2: 'PUBL_MSG', 3: 'RECV_STATE'}
+EVLOG_TEXT, EVLOG_NODE = 1, 4
+
+COLUMNS = ['protocol', 'pub_timing', 'run', 'node', 'event', 'name', 'seq', 'ns', 'value', 'phase']
+
+class Columns:
+    def __init__(self):
+        self.cols = {c: [] for c in COLUMNS[3:]}
+        # of the log being read
+        self.phase = None
+
+    def add(self, node, event, name=None, seq=None, ns=None, value=None):
+        c = self.cols
+        c['node'].append(node)
+        c['event'].append(event)
+        c['name'].append(name)
+        c['seq'].append(seq)
+        c['ns'].append(ns)
+        c['value'].append(value)
+        c['phase'].append(self.phase)
+
+    def add_message(self, node, msg, ns):
+        """Add the event of a text log message (see format() in log.hpp)"""
+        m = msg.split('::')
+        if m[0] == 'PHASE' and len(m) > 1:
+            self.phase = m[1]
+            self.add(node, m[0], m[1], ns=int(m[2]) if len(m) > 2 else ns)
+            return
+        if m[0] in ('PUBL_MSG', 'RECV_STATE') and len(m) > 2:
+            if m[0] == 'PUBL_MSG':
+                name, _, seq = m[2].rpartition('=')
+            else:
+                name, seq = m[1], m[2]
+            value = int(m[4]) if len(m) > 4 else None
+            try:
+                self.add(node, m[0], name, int(seq), int(m[3]) if len(m) > 3 else ns, value)
+                return
+            except ValueError:
+                pass
+        self.add(node, m[0], ns=ns)
+
+def _naive_ns(ts):
+    # the notebook takes the text log's local times as UTC
+    t = datetime.strptime(ts, "%Y-%m-%d %H:%M:%S.%f")
+    return int((t - datetime(1970, 1, 1)).total_seconds()) * 1000000000 + t.microsecond * 1000
+
+def read_text_log(filename, node, cols):
+    # times of lines that don't carry steady ns are mapped onto the steady
+    # clock through the RUN_ANCHOR line (if the log has one)
+    offset = 0
+    with open(filename, newline='') as f:
+        for row in csv.reader(f, skipinitialspace=True):
+            if len(row) < 4:
+                continue
+            try:
+                ns = _naive_ns(row[0])
+            except ValueError:
+                continue
+            if row[3].startswith('RUN_ANCHOR::'):
+                offset = int(row[3].split('::')[2]) - ns
+                continue
+            cols.add_message(node, row[3], ns + offset)
+
+def read_evlog(filename, node, cols):
+    with open(filename, 'rb') as f:
+        data = f.read()
+    names = {}
+    pos = 0
+    while pos + EVLOG_RECORD.size <= len(data):
+        if data[pos:pos + len(EVLOG_MAGIC)] == EVLOG_MAGIC:
+            names = {}
+            pos += EVLOG_HEADER.size
+            continue
+        ns, h, seq, _, rtype, length = EVLOG_RECORD.unpack_from(data, pos)
+        pos += EVLOG_RECORD.size
+        text = data[pos:pos + length]
+        pos += (length + EVLOG_RECORD.size - 1) // EVLOG_RECORD.size * EVLOG_RECORD.size
+        if rtype == EVLOG_NODE:
+            names[h] = text.decode(errors='replace')
+        elif rtype == EVLOG_TEXT:
+            cols.add_message(node, text.decode(errors='replace'), ns)
+        elif rtype in EVLOG_TYPES:
+            value = None
+            if length == 8:
+                # the publication's time
+                value = ns - struct.unpack('<Q', text)[0]
+            cols.add(node, EVLOG_TYPES[rtype], names.get(h), seq, ns, value)
+
+def read_status(filename, node, event, cols):
+    with open(filename) as f:
+        for line in f:
+            if "Channels" in line:
+                break
+            key, eq, value = line.strip().partition('=')
+            if eq:
+                try:
+                    cols.add(node, event, key, value=int(value))
+                except ValueError:
+                    pass
+
+def run_files(logpath):
+    """The files of a run's log directory that write_run() stores"""
+    files = []
+    for f in sorted(glob.glob(logpath + '/*.bin') + glob.glob(logpath + '/*.log')):
+        node, ext = os.path.splitext(os.path.basename(f))
+        if ext == '.log' and os.path.exists(os.path.join(logpath, node + '.bin')):
+            continue
+        files.append(f)
+    files += sorted(glob.glob(logpath + '/report-start-*.status'))
+    files += sorted(glob.glob(logpath + '/report-end-*.status'))
+    return files
+
+def write_run(logpath, filename, protocol, pub_timing, run):
+    """Store the run logged in logpath in filename (Parquet)"""
+    import pyarrow as pa
+    import pyarrow.parquet as pq
+
+    cols = Columns()
+    for f in run_files(logpath):
+        base, ext = os.path.splitext(os.path.basename(f))
+        cols.phase = None
+        if ext == '.bin':
+            read_evlog(f, base, cols)
+        elif ext == '.log':
+            read_text_log(f, base, cols)
+        elif base.startswith('report-start-'):
+            read_status(f, base[len('report-start-'):], 'NFD_STATUS_START', cols)
+        else:
+            read_status(f, base[len('report-end-'):], 'NFD_STATUS_END', cols)
+
+    n = len(cols.cols['node'])
+    table = pa.table({
+        'protocol': pa.array([protocol] * n, pa.string()).dictionary_encode(),
+        'pub_timing': pa.array([pub_timing] * n, pa.int32()),
+        'run': pa.array([run] * n, pa.int32()),
+        'node': pa.array(cols.cols['node'], pa.string()).dictionary_encode(),
+        'event': pa.array(cols.cols['event'], pa.string()).dictionary_encode(),
+        'name': pa.array(cols.cols['name'], pa.string()).dictionary_encode(),
+        'seq': pa.array(cols.cols['seq'], pa.int64()),
+        'ns': pa.array(cols.cols['ns'], pa.int64()),
+        'value': pa.array(cols.cols['value'], pa.int64()),
+        'phase': pa.array(cols.cols['phase'], pa.string()).dictionary_encode(),
+    })
+    pq.write_table(table, filename, compression='zstd')
+    return n
+
+def load(paths, columns=None, filter=None):
+    """
+    The events of the runs stored in paths (files or directories of them)
+    as one pyarrow Table, e.g.
+
+      load(LOG_MAIN_PATH, filter=pyarrow.dataset.field('event') == 'RECV_STATE')
+    """
+    import pyarrow.dataset as ds
+    if isinstance(paths, str):
+        paths = [paths]
+    files = []
+    for p in paths:
+        if os.path.isdir(p):
+            files += sorted(glob.glob(os.path.join(p, '**', '*.parquet'), recursive=True))
+        else:
+            files.append(p)
+    return ds.dataset(files, format='parquet').to_table(columns=columns, filter=filter)
@@ -28,24 +28,8 @@
 #include <string>
 #include <thread>
 
-#include <boost/log/core.hpp>
-#include <boost/log/trivial.hpp>
-#include <boost/log/utility/setup/common_attributes.hpp>
-#include <boost/log/utility/setup/file.hpp>
-
-namespace logging = boost::log;
-namespace keywords = boost::log::keywords;
-
-void initlogger(std::string filename) {
-	logging::add_common_attributes();
-	logging::add_file_log
-	(
-		keywords::file_name = filename,
-		keywords::format = "\"%TimeStamp%\", \"%ProcessID%\", \"%ThreadID%\", \"%Message%\"",
-		keywords::open_mode = std::ios_base::app,
-		keywords::auto_flush = true
-	);
-}
+#include "log.hpp"
+#include "threads.hpp"
 
 int averageTimeBetweenPublishesInMilliseconds = 5000;
 int varianceInTimeBetweenPublishesInMilliseconds = 1000;
@@ -64,11 +48,15 @@ public:
    * Set syncInterestLifetime and syncReplyFreshness to 1.6 seconds
    * userPrefix is the default user prefix, no updates are published on it in this example
    */
-  Producer(const std::string& userPrefix)
+  Producer(const std::string& userPrefix, const std::string& logfile,
+           bool threaded = false, int appBusyUs = 0)
     : m_userPrefix(userPrefix)
-    , m_scheduler(m_face.getIoService())
+    , m_threaded(threaded)
+    , m_appBusyUs(appBusyUs)
+    , m_scheduler(m_threaded ? m_appIo : m_face.getIoService())
+    , m_phases(logfile)
     , m_fullProducer(std::make_shared<psync::FullProducer>(
-                      6, m_face, "/ndn/svs", userPrefix,
+                      6, m_face, syncPrefix(), userPrefix,
                       std::bind(&Producer::processSyncUpdate, this, _1),
                       1000_ms, 1000_ms))
     , m_rng(ndn::random::getRandomNumberEngine())
@@ -85,62 +73,120 @@ public:
   run()
   {
     BOOST_LOG_TRIVIAL(info) << "NODE_INIT::" << m_userPrefix;
-    m_face.processEvents();
+    if (!m_threaded) {
+      m_face.processEvents();
+      return;
+    }
+
+    // sync runs on this thread, the application on appThread
+    m_log.start();
+    boost::asio::io_service::work appWork(m_appIo);
+    std::thread appThread([this] { m_appIo.run(); });
+    m_face.processEvents(ndn::time::milliseconds::zero(), true);
+    m_appIo.stop();
+    appThread.join();
+    m_log.stop();
   }
 
   void
   runIter()
   {
-    if (start_time == 0) {
-      start_time = static_cast<long int> (time(NULL));
+    auto curr_time = std::chrono::steady_clock::now();
+    if (start_time == std::chrono::steady_clock::time_point()) {
+      start_time = curr_time;
     }
+    auto phase = m_phases.at(curr_time - start_time);
 
-    long int curr_time = static_cast<long int> (time(NULL));
-
-    if (curr_time - start_time <= 120) {
+    if (phase == Phases::WARMUP || phase == Phases::MEASURE) {
       curr_i++;
       std::ostringstream ss = std::ostringstream();
       ss << m_userPrefix << "=" << curr_i;
       std::string message = ss.str();
       publishMsg(message);
-      BOOST_LOG_TRIVIAL(info) << "PUBL_MSG::" << m_userPrefix << "::" << message;
+      m_log.event(evlog::PUBL_MSG, m_userPrefix, curr_i);
+      m_phases.published();
     }
 
-    if (curr_time - start_time <= 120 + 30) {
-      m_scheduler.schedule(ndn::time::milliseconds(m_sleepTime(m_rng)),
+    if (phase != Phases::DONE) {
+      int sleepMs = m_sleepTime(m_rng);
+      // all that's left to do is notice that the nodes have converged
+      if (phase == Phases::DRAIN && m_phases.earlyExit()) {
+        sleepMs = std::min(sleepMs, 1000);
+      }
+      m_scheduler.schedule(ndn::time::milliseconds(sleepMs),
                            [this] { runIter(); });
       return;
     }
 
-    m_fullProducer.reset();
-    m_face.shutdown();
+    onFace([this] {
+      m_fullProducer.reset();
+      m_face.shutdown();
+    });
   }
 
 private:
   void
   publishMsg(std::string msg)
   {
-    ndn::Name prefix(m_userPrefix);
-    m_fullProducer->publishName(prefix);
+    onFace([this] {
+      ndn::Name prefix(m_userPrefix);
+      m_fullProducer->publishName(prefix);
+    });
   }
 
   void
   processSyncUpdate(const std::vector<psync::MissingDataInfo>& updates)
+  {
+    onApp([this, updates] { logSyncUpdate(updates); });
+  }
+
+  void
+  logSyncUpdate(const std::vector<psync::MissingDataInfo>& updates)
   {
     for (const auto& update : updates) {
       for (uint64_t i = update.lowSeq; i <= update.highSeq; i++) {
-        BOOST_LOG_TRIVIAL(info) << "RECV_STATE::" << update.prefix << "::" << i;
+        spinFor(m_appBusyUs);
+        m_log.event(evlog::RECV_STATE, update.prefix, i);
+        m_phases.received(update.prefix, i);
         // BOOST_LOG_TRIVIAL(info) << "RECV_MSG::" << m_userPrefix << "::" << update.prefix << "=" << i;
       }
     }
   }
 
+  // run 'f' on the sync (face) thread
+  void
+  onFace(std::function<void()> f)
+  {
+    if (m_threaded)
+      m_toFace.post(std::move(f));
+    else
+      f();
+  }
+
+  // run 'f' on the application thread
+  void
+  onApp(std::function<void()> f)
+  {
+    if (m_threaded)
+      m_toApp.post(std::move(f));
+    else
+      f();
+  }
+
 private:
   std::string m_userPrefix;
+  bool m_threaded;
+  int m_appBusyUs;
   ndn::Face m_face;
+  // application thread's io_service (only used if threaded)
+  boost::asio::io_service m_appIo;
   ndn::Scheduler m_scheduler;
+  TaskQueue m_toFace{m_face.getIoService()};
+  TaskQueue m_toApp{m_appIo};
+  AsyncLog m_log;
+  Phases m_phases;
 
-  long int start_time = 0;
+  std::chrono::steady_clock::time_point start_time;
   int curr_i = 0;
 
   std::shared_ptr<psync::FullProducer> m_fullProducer;
@@ -152,8 +198,8 @@ private:
 int
 main(int argc, char* argv[])
 {
-  if (argc != 4) {
-    BOOST_LOG_TRIVIAL(error) << "USAGE: ./eval prefix logfile publish_time";
+  if (argc < 4 || argc > 6) {
+    BOOST_LOG_TRIVIAL(error) << "USAGE: ./eval prefix logfile publish_time [mt [app_busy_us]]";
     exit(1);
   }
 
@@ -163,7 +209,9 @@ main(int argc, char* argv[])
   initlogger(std::string(argv[2]));
 
   try {
-    Producer producer(argv[1]);
+    // optional "mt" [app busy us]: multi-threaded mode
+    Producer producer(argv[1], argv[2], argc > 4 && std::string(argv[4]) == "mt",
+                      argc > 5 ? strtol(argv[5], NULL, 10) : 0);
     producer.run();
   }
   catch (const std::exception& e) {
@@ -0,0 +1,686 @@
+# -*- Mode:python; c-file-style:"gnu"; indent-tabs-mode:nil -*- */
+#
+# Discrete-event simulation of the sync experiments svs.py runs in
+# Mini-NDN.
+#
+# Each node runs the eval harness' publishing loop (runIter: publish
+# every PUB_TIMING +-20% ms through the warmup and measurement windows,
+# stop after the drain window or, with --early-exit, once every node
+# has converged; see Phases in log.hpp) on top of a model
+# of the sync protocol. The forwarder is reduced to the one-way delays
+# between the nodes in GEANT-routes.json (plus optional jitter and
+# loss): sync interests are multicast to every other node and data goes
+# straight back to whoever sent the interest. As with a PIT, only the
+# first data answering a node's current sync interest is taken, later
+# ones are dropped (but counted). Time is virtual so a run
+# takes seconds instead of minutes and needs neither NFD nor routing.
+# The publishing hosts of a run are the ones svs.py picks only when
+# given its topology file (--topo).
+#
+# The output is what svs.py leaves behind: a directory per run,
+# <out>/<protocol>/<prefix>-<pub timing>-<run>, holding each node's log
+# in the harness' CSV format (with steady clock ns, see log.hpp) and
+# report-start/end-<node>.status files with the node's nInInterests and
+# nInData. The notebook, tools/log-analyze and evstore.py read them as
+# they read real runs. Unlike NFD's, the counters only count packets
+# that reach the node, not those it forwards.
+#
+# The protocol models keep what drives latency and overhead:
+#
+#   svs         state vector sync interests on every publication and
+#               every 30 s +-10%; an interest that is behind our vector
+#               starts a suppression timer (up to 200 ms) after which
+#               we send ours unless the interests seen meanwhile made it
+#               redundant
+#   chronosync  outstanding sync interests carrying the state digest,
+#               answered with the difference when the state changes;
+#               unknown digests get the full state after a recovery
+#               delay
+#   psync       sync interests carrying the set of latest names (the
+#               IBF), answered at once if the receiver has names the
+#               sender lacks, otherwise kept pending until it does
+#   syncps      like psync but the replies carry the publications
+#               themselves (so receivers know each one's latency), the
+#               publications only stay in the set for 1 s and a reply
+#               holds at most 1300 bytes of them
+#
+#   python3 sim.py -p svs,syncps -t 500,1000,2000 -r 1-9 -o /tmp/simlog \
+#       --topo ~/mini-ndn/topologies/geant_l0.conf
+
+import argparse
+import heapq
+import json
+import os
+import random
+import re
+from datetime import datetime, timedelta
+
+MS = 1000000
+S = 1000 * MS
+
+# start of the simulated clocks
+WALL_EPOCH = datetime(2021, 1, 1)
+STEADY_EPOCH = 1000 * S
+
+class Sim:
+    """
+    The events are [when, count, fn, args] lists on a heap. schedule()
+    returns the event so it can be passed to cancel().
+    """
+    def __init__(self):
+        self.now = 0
+        self.queue = []
+        self.count = 0
+
+    def schedule(self, delay, fn, *args):
+        self.count += 1
+        e = [self.now + int(delay), self.count, fn, args]
+        heapq.heappush(self.queue, e)
+        return e
+
+    def run(self):
+        queue = self.queue
+        pop = heapq.heappop
+        while queue:
+            when, _, fn, args = pop(queue)
+            if fn is not None:
+                self.now = when
+                fn(*args)
+
+def cancel(event):
+    if event is not None:
+        event[2] = None
+
+class Net:
+    """One-way delays between the nodes (the routes are in ms)"""
+    def __init__(self, sim, routes, rng, jitter_ms=0, loss=0.0):
+        self.sim = sim
+        self.routes = routes
+        self.rng = rng
+        self.jitter = jitter_ms * MS
+        self.loss = loss
+        self.nodes = []
+
+    def delay(self, src, dst):
+        d = self.routes[src.host][dst.host] * MS
+        return d + self.rng.random() * self.jitter if self.jitter else d
+
+    def lost(self):
+        return self.loss and self.rng.random() < self.loss
+
+    # the packets call 'handler' of the receiving node's protocol
+
+    def send_interest(self, src, dst, handler, *args):
+        if not self.lost():
+            self.sim.schedule(self.delay(src, dst), self.deliver, dst, 'nInInterests', handler, args)
+
+    def send_data(self, src, dst, handler, *args):
+        if not self.lost():
+            self.sim.schedule(self.delay(src, dst), self.deliver, dst, 'nInData', handler, args)
+
+    def multicast_interest(self, src, handler, *args):
+        for dst in self.nodes:
+            if dst is not src and not self.lost():
+                self.sim.schedule(self.delay(src, dst), self.deliver, dst, 'nInInterests', handler, args)
+
+    def deliver(self, dst, counter, handler, args):
+        dst.counters[counter] += 1
+        if dst.running:
+            getattr(dst.proto, handler)(*args)
+
+class Phases:
+    """The run's windows in s (EVAL_WARMUP, EVAL_MEASURE, EVAL_DRAIN)"""
+    def __init__(self, warmup=0, measure=120, drain=30, early_exit=False):
+        self.warmup = warmup
+        self.measure = measure
+        self.drain = drain
+        self.early_exit = early_exit
+
+class Node:
+    """A host running the eval harness"""
+    def __init__(self, sim, net, host, rng, pub_timing, protocol, phases):
+        self.sim = sim
+        self.net = net
+        self.host = host
+        self.id = "/ndn/{0}-site/{0}/svs_chat/{0}".format(host)
+        self.rng = rng
+        self.pub_timing = pub_timing
+        self.lines = []
+        self.counters = {'nInInterests': 0, 'nInData': 0}
+        self.running = False
+        self.curr_i = 0
+        self.start_time = None
+        self.phases = phases
+        self.phase = None
+        # the count of publications once we stopped publishing, the
+        # publications received (only kept with early_exit)
+        self.final = None
+        self.received = set()
+        self.converged = False
+        self.proto = protocol(self)
+
+    def log(self, msg):
+        self.lines.append((self.sim.now, msg))
+
+    def publ(self, seq):
+        self.log("PUBL_MSG::{0}::{0}={1}::{2}".format(self.id, seq, STEADY_EPOCH + self.sim.now))
+
+    def recv(self, name, seq, pub_ns=None):
+        if self.phases.early_exit:
+            self.received.add((name, seq))
+        ns = STEADY_EPOCH + self.sim.now
+        if pub_ns is None:
+            self.log("RECV_STATE::{}::{}::{}".format(name, seq, ns))
+        else:
+            self.log("RECV_STATE::{}::{}::{}::{}".format(name, seq, ns, ns - pub_ns))
+
+    def timer(self, delay, fn, *args):
+        return self.sim.schedule(delay, fn, *args)
+
+    def start(self):
+        self.running = True
+        self.log("RUN_ANCHOR::{}::{}".format(self.wall_ns(self.sim.now), STEADY_EPOCH + self.sim.now))
+        self.log("NODE_INIT::" + self.id)
+        self.proto.start()
+        self.timer(self.sleep_time(), self.run_iter)
+
+    def sleep_time(self):
+        var = self.pub_timing // 5
+        return self.rng.randint(self.pub_timing - var, self.pub_timing + var) * MS
+
+    def phase_at(self, elapsed):
+        p = self.phases
+        if elapsed < p.warmup * S:
+            phase = 'WARMUP'
+        elif elapsed <= (p.warmup + p.measure) * S:
+            phase = 'MEASURE'
+        elif elapsed <= (p.warmup + p.measure + p.drain) * S:
+            phase = 'DRAIN'
+        else:
+            phase = 'DONE'
+
+        if phase in ('DRAIN', 'DONE') and self.final is None:
+            self.final = self.curr_i
+        if phase == 'DRAIN' and p.early_exit and self.all_converged():
+            phase = 'DONE'
+        if phase != self.phase:
+            self.log("PHASE::{}::{}".format(phase, STEADY_EPOCH + self.sim.now))
+            self.phase = phase
+        return phase
+
+    def all_converged(self):
+        nodes = self.net.nodes
+        if not self.converged:
+            if any(n.final is None for n in nodes):
+                return False
+            if len(self.received) < sum(n.final for n in nodes if n is not self):
+                return False
+            self.converged = True
+        return all(n.converged for n in nodes)
+
+    def run_iter(self):
+        if self.start_time is None:
+            self.start_time = self.sim.now
+        phase = self.phase_at(self.sim.now - self.start_time)
+        if phase in ('WARMUP', 'MEASURE'):
+            self.curr_i += 1
+            self.proto.publish(self.curr_i)
+            self.publ(self.curr_i)
+        if phase != 'DONE':
+            delay = self.sleep_time()
+            # all that's left to do is notice that the nodes have converged
+            if phase == 'DRAIN' and self.phases.early_exit:
+                delay = min(delay, S)
+            self.timer(delay, self.run_iter)
+            return
+        self.running = False
+        self.proto.stop()
+
+    def wall_ns(self, t):
+        return int((WALL_EPOCH - datetime(1970, 1, 1)).total_seconds()) * S + t
+
+    def write_log(self, filename):
+        pid = self.rng.randrange(1 << 16)
+        with open(filename, 'w') as f:
+            for t, msg in self.lines:
+                ts = (WALL_EPOCH + timedelta(microseconds=t // 1000)).strftime("%Y-%m-%d %H:%M:%S.%f")
+                f.write('"{}", "0x{:08x}", "0x{:016x}", "{}"\n'.format(ts, pid, 0x7f0000000000 + pid, msg))
+
+# ============================ protocols ============================
+
+class Svs:
+    PERIODIC = 30 * S
+    SUPPRESSION = 200 * MS
+
+    def __init__(self, node):
+        self.node = node
+        self.vv = {}
+        self.recorded = None
+        self.retx = None
+
+    def start(self):
+        self.retx_sync_interest()
+
+    def stop(self):
+        cancel(self.retx)
+
+    def publish(self, seq):
+        self.vv[self.node.id] = seq
+        self.retx_sync_interest()
+
+    def schedule_retx(self, delay):
+        cancel(self.retx)
+        self.retx = self.node.timer(delay, self.retx_sync_interest)
+
+    def periodic(self):
+        return self.PERIODIC * self.node.rng.uniform(0.9, 1.1)
+
+    def retx_sync_interest(self):
+        if self.recorded is None:
+            self.send_sync_interest()
+            self.node.log("SYNC_REPLY_SENT_NO_RECORD")
+        elif self.merge(self.recorded, log=False)[0]:
+            self.send_sync_interest()
+            self.node.log("SYNC_REPLY_SENT_RECORD_OLD")
+        else:
+            self.node.log("SYNC_REPLY_SUPPRESSED")
+        self.recorded = None
+        self.schedule_retx(self.periodic())
+
+    def send_sync_interest(self):
+        self.node.net.multicast_interest(self.node, 'on_sync_interest', dict(self.vv))
+        self.node.log("SEND_SYNC_INT")
+
+    def merge(self, other, log=True):
+        """(our vector is newer, theirs is newer); merges theirs if log"""
+        my_newer = any(other.get(k, 0) < v for k, v in self.vv.items())
+        other_newer = False
+        for k, v in other.items():
+            mine = self.vv.get(k, 0)
+            if v > mine:
+                other_newer = True
+                if log:
+                    for s in range(mine + 1, v + 1):
+                        self.node.recv(k, s)
+                    self.vv[k] = v
+        return my_newer, other_newer
+
+    def on_sync_interest(self, vv):
+        my_newer, other_newer = self.merge(vv)
+        if self.recorded is not None:
+            # suppressing: remember what the others have
+            for k, v in vv.items():
+                self.recorded[k] = max(self.recorded.get(k, 0), v)
+        elif my_newer:
+            self.recorded = dict(vv)
+            self.schedule_retx(self.node.rng.random() * self.SUPPRESSION)
+        elif not other_newer:
+            self.schedule_retx(self.periodic())
+
+class ChronoSync:
+    LIFETIME = 1000 * MS
+    REEXPRESS_JITTER = 100 * MS
+    RECOVERY_DELAY = 200 * MS
+    LOG_SIZE = 100
+
+    def __init__(self, node):
+        self.node = node
+        self.session = None
+        self.state = {}
+        self.history = {}       # old digests -> state then
+        self.pending = {}       # node -> (nonce, digest, expiry)
+        self.reexpress = None
+        self.nonce = 0          # of our sync interest (None once answered)
+        self.nonces = 0
+
+    @staticmethod
+    def digest(state):
+        return hash(frozenset(state.items()))
+
+    def start(self):
+        self.session = "{}/{}".format(self.node.id, self.node.wall_ns(self.node.sim.now) // MS)
+        self.state[self.session] = 0
+        self.send_sync_interest()
+
+    def stop(self):
+        cancel(self.reexpress)
+
+    def publish(self, seq):
+        self.update({self.session: seq}, log=False)
+        self.send_sync_interest()
+
+    def send_sync_interest(self):
+        cancel(self.reexpress)
+        self.nonces += 1
+        self.nonce = self.nonces
+        self.node.net.multicast_interest(self.node, 'on_sync_interest', self.node, self.nonce,
+                                         self.digest(self.state))
+        self.node.log("SEND_SYNC_INT")
+        delay = self.LIFETIME + self.node.rng.random() * self.REEXPRESS_JITTER
+        self.reexpress = self.node.timer(delay, self.send_sync_interest)
+
+    def on_sync_interest(self, src, nonce, digest):
+        if digest == self.digest(self.state):
+            self.pending[src] = (nonce, digest, self.node.sim.now + self.LIFETIME)
+        elif digest in self.history:
+            self.reply(src, nonce, self.diff(self.history[digest]))
+        else:
+            self.node.timer(self.RECOVERY_DELAY, self.recover, src, nonce, digest)
+
+    def recover(self, src, nonce, digest):
+        if self.node.running and digest not in self.history and digest != self.digest(self.state):
+            self.reply(src, nonce, dict(self.state))
+
+    def diff(self, old):
+        return {k: v for k, v in self.state.items() if old.get(k, -1) < v}
+
+    def reply(self, dst, nonce, diff):
+        if diff:
+            self.node.net.send_data(self.node, dst, 'on_sync_data', nonce, diff)
+
+    def on_sync_data(self, nonce, diff):
+        if nonce != self.nonce:
+            return
+        self.nonce = None
+        self.update(diff, log=True)
+        self.send_sync_interest()
+
+    def update(self, diff, log):
+        old = dict(self.state)
+        changed = False
+        for k, v in diff.items():
+            mine = self.state.get(k, 0)
+            if v > mine or k not in self.state:
+                if log:
+                    for s in range(mine + 1, v + 1):
+                        self.node.recv(k, s)
+                self.state[k] = v
+                changed = True
+        if not changed:
+            return False
+        self.history[self.digest(old)] = old
+        if len(self.history) > self.LOG_SIZE:
+            del self.history[next(iter(self.history))]
+        # answer the interests that were waiting on the old state
+        now = self.node.sim.now
+        for src, (nonce, digest, expiry) in self.pending.items():
+            if expiry >= now and digest in self.history:
+                self.reply(src, nonce, self.diff(self.history[digest]))
+        self.pending.clear()
+        return True
+
+class PSync:
+    LIFETIME = 1000 * MS
+    JITTER = 100 * MS
+
+    def __init__(self, node):
+        self.node = node
+        self.state = {}
+        self.pending = {}       # node -> (nonce, their state, expiry)
+        self.reexpress = None
+        self.nonce = 0          # of our sync interest (None once answered)
+        self.nonces = 0
+
+    def start(self):
+        self.state[self.node.id] = 0
+        self.send_sync_interest()
+
+    def stop(self):
+        cancel(self.reexpress)
+
+    def publish(self, seq):
+        self.state[self.node.id] = seq
+        self.satisfy_pending()
+
+    def send_sync_interest(self):
+        cancel(self.reexpress)
+        self.nonces += 1
+        self.nonce = self.nonces
+        self.node.net.multicast_interest(self.node, 'on_sync_interest', self.node, self.nonce,
+                                         dict(self.state))
+        delay = self.LIFETIME / 2 + self.node.rng.random() * self.JITTER
+        self.reexpress = self.node.timer(delay, self.send_sync_interest)
+
+    def missing(self, theirs):
+        return {k: v for k, v in self.state.items() if theirs.get(k, 0) < v}
+
+    def on_sync_interest(self, src, nonce, theirs):
+        diff = self.missing(theirs)
+        if diff:
+            self.reply(src, nonce, diff)
+        else:
+            self.pending[src] = (nonce, theirs, self.node.sim.now + self.LIFETIME)
+
+    def reply(self, dst, nonce, diff):
+        self.node.net.send_data(self.node, dst, 'on_sync_data', nonce, diff)
+
+    def satisfy_pending(self):
+        now = self.node.sim.now
+        for src, (nonce, theirs, expiry) in list(self.pending.items()):
+            if expiry < now:
+                del self.pending[src]
+                continue
+            diff = self.missing(theirs)
+            if diff:
+                self.reply(src, nonce, diff)
+                del self.pending[src]
+
+    def on_sync_data(self, nonce, diff):
+        if nonce != self.nonce:
+            return
+        self.nonce = None
+        new = False
+        for k, v in diff.items():
+            mine = self.state.get(k, 0)
+            if v > mine:
+                for s in range(mine + 1, v + 1):
+                    self.node.recv(k, s)
+                self.state[k] = v
+                new = True
+        if new:
+            self.satisfy_pending()
+        self.send_sync_interest()
+
+class SyncPs:
+    LIFETIME = 1000 * MS
+    PUB_LIFETIME = 1000 * MS
+    MAX_PUB_BYTES = 1300
+
+    def __init__(self, node):
+        self.node = node
+        self.active = {}        # (name, seq) -> (publish ns, size)
+        self.seen = set()
+        self.pending = {}       # node -> (nonce, their pubs, expiry)
+        self.reexpress = None
+        self.nonce = 0          # of our sync interest (None once answered)
+        self.nonces = 0
+
+    def start(self):
+        self.send_sync_interest()
+
+    def stop(self):
+        cancel(self.reexpress)
+
+    def publish(self, seq):
+        key = (self.node.id, seq)
+        content = "{}::{}::{}".format(self.node.id, seq, STEADY_EPOCH + self.node.sim.now)
+        self.add(key, STEADY_EPOCH + self.node.sim.now, len(content))
+        self.satisfy_pending()
+
+    def add(self, key, pub_ns, size):
+        self.seen.add(key)
+        self.active[key] = (pub_ns, size)
+        self.node.timer(self.PUB_LIFETIME, self.active.pop, key, None)
+
+    def send_sync_interest(self):
+        cancel(self.reexpress)
+        self.nonces += 1
+        self.nonce = self.nonces
+        self.node.net.multicast_interest(self.node, 'on_sync_interest', self.node, self.nonce,
+                                         frozenset(self.active))
+        self.reexpress = self.node.timer(self.LIFETIME - 20 * MS, self.send_sync_interest)
+
+    def missing(self, theirs):
+        # newest first, as much as fits in a reply
+        new = self.active.keys() - theirs
+        if not new:
+            return []
+        pubs = sorted(((self.active[k][0], k) for k in new), reverse=True)
+        out, size = [], 0
+        for pub_ns, k in pubs:
+            n = self.active[k][1]
+            if out and size + n > self.MAX_PUB_BYTES:
+                break
+            out.append((k, pub_ns, n))
+            size += n
+        return out
+
+    def on_sync_interest(self, src, nonce, theirs):
+        pubs = self.missing(theirs)
+        if pubs:
+            self.node.net.send_data(self.node, src, 'on_sync_data', nonce, pubs)
+        else:
+            self.pending[src] = (nonce, theirs, self.node.sim.now + self.LIFETIME)
+
+    def satisfy_pending(self):
+        now = self.node.sim.now
+        for src, (nonce, theirs, expiry) in list(self.pending.items()):
+            if expiry >= now:
+                pubs = self.missing(theirs)
+                if not pubs:
+                    continue
+                self.node.net.send_data(self.node, src, 'on_sync_data', nonce, pubs)
+            del self.pending[src]
+
+    def on_sync_data(self, nonce, pubs):
+        if nonce != self.nonce:
+            return
+        self.nonce = None
+        new = False
+        for key, pub_ns, size in pubs:
+            if key in self.seen:
+                continue
+            self.node.recv(key[0], key[1], pub_ns)
+            self.add(key, pub_ns, size)
+            new = True
+        if new:
+            self.satisfy_pending()
+        cancel(self.reexpress)
+        self.reexpress = self.node.timer(3 * MS, self.send_sync_interest)
+
+PROTOCOLS = {
+    'svs': Svs,
+    'chronosync': ChronoSync,
+    'psync': PSync,
+    'syncps': SyncPs,
+}
+
+# ===================================================================
+
+def read_topo(filename):
+    """
+    The hosts svs.py picks the publishing hosts from, in the same order:
+    Mininet's (natural sort of the names) keeping those with fewer than
+    8 links, from a Mini-NDN topology file
+    """
+    section = None
+    hosts = []
+    links = {}
+    with open(filename) as f:
+        for line in f:
+            line = line.split('#')[0].strip()
+            if line.startswith('['):
+                section = line.strip('[]')
+            elif line and section == 'nodes':
+                hosts.append(line.split(':')[0].strip())
+            elif line and section == 'links':
+                for h in line.split()[0].split(':'):
+                    links[h] = links.get(h, 0) + 1
+    natural = lambda h: [int(t) if t.isdigit() else t for t in re.split(r'(\d+)', h)]
+    return [h for h in sorted(hosts, key=natural) if links.get(h, 0) < 8]
+
+def run(routes, protocol, pub_timing, run_number, num_nodes, logpath, jitter_ms=0, loss=0.0,
+        phases=Phases(), candidates=None):
+    """
+    Simulate one run and write its logs to logpath. The nodes are sampled
+    from candidates (see read_topo) as svs.py does, or without them from
+    the routes' hosts, which picks different hosts than the real runs.
+    """
+    rng = random.Random("{}-{}-{}".format(protocol, pub_timing, run_number))
+    sim = Sim()
+    net = Net(sim, routes, rng, jitter_ms, loss)
+    hosts = random.Random(run_number).sample(candidates or sorted(routes), num_nodes)
+    net.nodes = [Node(sim, net, h, rng, pub_timing, PROTOCOLS[protocol], phases) for h in hosts]
+    for node in net.nodes:
+        # svs.py starts the nodes one after the other
+        sim.schedule(rng.random() * S, node.start)
+    sim.run()
+
+    os.makedirs(logpath + '/stdout', exist_ok=True)
+    os.makedirs(logpath + '/stderr', exist_ok=True)
+    for node in net.nodes:
+        node.write_log("{}/{}.log".format(logpath, node.host))
+        with open("{}/report-start-{}.status".format(logpath, node.host), "w") as f:
+            f.write("General NFD status:\n  nInInterests=0\n  nInData=0\n")
+        with open("{}/report-end-{}.status".format(logpath, node.host), "w") as f:
+            f.write("General NFD status:\n")
+            for k, v in node.counters.items():
+                f.write("  {}={}\n".format(k, v))
+    return sim.count
+
+def run_point(args, routes, protocol, pub_timing, run_number):
+    logpath = "{}/{}/{}-{}-{}".format(args.out, protocol, args.prefix, pub_timing, run_number)
+    phases = Phases(args.warmup, args.measure, args.drain, args.early_exit)
+    candidates = read_topo(args.topo) if args.topo else None
+    events = run(routes, protocol, pub_timing, run_number, args.nodes, logpath, args.jitter, args.loss,
+                 phases, candidates)
+    if args.store:
+        import evstore
+        evstore.write_run(logpath, logpath + ".parquet", protocol, pub_timing, run_number)
+    return "{}: {} events".format(logpath, events)
+
+def parse_list(s):
+    values = []
+    for part in s.split(','):
+        lo, _, hi = part.partition('-')
+        values += range(int(lo), int(hi or lo) + 1)
+    return values
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description="Simulate the sync experiments of svs.py")
+    parser.add_argument('-p', '--protocols', default=','.join(PROTOCOLS),
+                        help="comma separated, of " + ", ".join(PROTOCOLS))
+    parser.add_argument('-t', '--pub-timings', default="1000,5000,10000,15000")
+    parser.add_argument('-r', '--runs', default="1-3", help="e.g. 1-9 or 1,3,5")
+    parser.add_argument('-n', '--nodes', type=int, default=20)
+    parser.add_argument('--prefix', default="GEANT_L0", help="LOG_PREFIX of svs.py")
+    parser.add_argument('--routes', default="GEANT-routes.json")
+    parser.add_argument('--topo', help="TOPO_FILE of svs.py, to simulate the hosts it picks "
+                        "(otherwise they differ from the real runs')")
+    parser.add_argument('--jitter', type=float, default=0, help="ms added to each packet's delay, at most")
+    parser.add_argument('--loss', type=float, default=0, help="probability a packet is lost")
+    parser.add_argument('--warmup', type=int, default=0, help="s of publishing before the measurement")
+    parser.add_argument('--measure', type=int, default=120, help="s of publishing measured")
+    parser.add_argument('--drain', type=int, default=30, help="s after the last publication, at most")
+    parser.add_argument('--early-exit', action='store_true',
+                        help="end a run's drain once every node has converged")
+    parser.add_argument('--store', action='store_true', help="also store each run with evstore.py")
+    parser.add_argument('-j', '--jobs', type=int, default=1, help="runs simulated at once")
+    parser.add_argument('-o', '--out', required=True, help="LOG_MAIN_PATH of svs.py")
+    args = parser.parse_args()
+
+    with open(args.routes) as f:
+        routes = json.load(f)
+
+    points = [(args, routes, protocol, pub_timing, run_number)
+              for protocol in args.protocols.split(',')
+              for pub_timing in parse_list(args.pub_timings)
+              for run_number in parse_list(args.runs)]
+    if args.jobs > 1:
+        from multiprocessing import Pool
+        with Pool(args.jobs) as pool:
+            for line in pool.starmap(run_point, points):
+                print(line)
+    else:
+        for p in points:
+            print(run_point(*p))
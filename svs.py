@@ -24,14 +24,15 @@
 import random
 import time
 import configparser
-import psutil
+import json
 import os
+import queue
+import shutil
+import threading
 from collections import defaultdict
 
 from mininet.log import setLogLevel, info
 
-from minindn.apps.application import Application
-
 from minindn.helpers.nfdc import Nfdc
 from minindn.minindn import Minindn
 from minindn.util import MiniNDNCLI
@@ -42,6 +43,8 @@ from mininet.node import OVSController
 
 from tqdm import tqdm
 
+import evstore
+
 # ======================= CONFIGURATION ============================
 OVERALL_RUN = 2
 DEBUG_GDB = False
@@ -49,6 +52,35 @@ NUM_NODES = 20
 PUB_TIMING_VALS = [1000, 5000, 10000, 15000]
 RUN_NUMBER_VALS = list(range(1, 4))
 LOG_PREFIX = "GEANT_L0"
+# run sync, the application and logging on separate threads, with
+# APP_BUSY_US microseconds of application work per update received
+THREADED = False
+APP_BUSY_US = 0
+# write binary event logs (<node>.bin) and decode them to <node>.log with
+# this decoder (tools/evlog-decode) once each run is over
+EVLOG_DECODE = None
+# store each run's events and NFD status counters in one Parquet file,
+# <LOG_MAIN_DIRECTORY>/<LOG_PREFIX>-<PUB_TIMING>-<RUN_NUMBER>.parquet
+# (see evstore.py), and unless EVSTORE_KEEP_LOGS remove the files it
+# was made from
+EVSTORE = False
+EVSTORE_KEEP_LOGS = True
+# seconds each node publishes before the measurement, publishes while
+# measured, and waits for the last publications after (the PHASE events
+# in the logs mark them, see Phases in log.hpp). With EARLY_EXIT the
+# drain ends as soon as every node has all the publications.
+WARMUP_S = 0
+MEASURE_S = 120
+DRAIN_S = 30
+EARLY_EXIT = False
+# number of experiment points (executable, pub timing, run) run at the
+# same time; each gets its own sync prefix /ndn/svs/<slot> and a set of
+# hosts no other running point uses (so at most hosts / NUM_NODES of
+# them: 2 on GEANT with 20 nodes). Starting a point then only erases
+# its own names from the content stores, and no NFD status reports are
+# taken as the nodes' counters would include the other points' traffic
+# (log-analyze leaves interests_data empty).
+PARALLEL_POINTS = 1
 TOPO_FILE = "topologies/geant_l0.conf"
 
 SYNC_EXEC_VALS = [
@@ -65,63 +97,142 @@ LOG_MAIN_DIRECTORY_VALS = [
     LOG_MAIN_PATH + "psync/",                                     # PSync
     #LOG_MAIN_PATH + "syncps/",                                    # syncps
 ]
+# points that completed, so that a sweep that was interrupted picks up
+# where it stopped when run again (delete it to start over)
+SWEEP_STATE = LOG_MAIN_PATH + "sweep-state.json"
 # ==================================================================
 
-RUN_NUMBER = 0
-PUB_TIMING = 0
-SYNC_EXEC = None
-LOG_MAIN_DIRECTORY = None
-
-def getLogPath():
-    LOG_NAME = "{}-{}-{}".format(LOG_PREFIX, PUB_TIMING, RUN_NUMBER)
-    logpath = LOG_MAIN_DIRECTORY + LOG_NAME
-
-    if not os.path.exists(logpath):
-        os.makedirs(logpath)
-        os.chown(logpath, 1000, 1000)
-
-        os.makedirs(logpath + '/stdout')
-        os.chown(logpath + '/stdout', 1000, 1000)
-        os.makedirs(logpath + '/stderr')
-        os.chown(logpath + '/stdout', 1000, 1000)
-
-    return logpath
-
-class SvsChatApplication(Application):
+class Point:
+    """
+    One experiment point of the sweep: an executable run with a pub timing
+    """
+    def __init__(self, sync_exec, log_main_directory, pub_timing, run_number):
+        self.sync_exec = sync_exec
+        self.log_main_directory = log_main_directory
+        self.pub_timing = pub_timing
+        self.run_number = run_number
+        self.prefix = "/ndn/svs"
+        self.hosts = []
+        LOG_NAME = "{}-{}-{}".format(LOG_PREFIX, pub_timing, run_number)
+        self.logpath = log_main_directory + LOG_NAME
+
+    def getLogPath(self):
+        logpath = self.logpath
+
+        if not os.path.exists(logpath):
+            os.makedirs(logpath)
+            os.chown(logpath, 1000, 1000)
+
+            os.makedirs(logpath + '/stdout')
+            os.chown(logpath + '/stdout', 1000, 1000)
+            os.makedirs(logpath + '/stderr')
+            os.chown(logpath + '/stdout', 1000, 1000)
+
+        return logpath
+
+def get_svs_identity(node):
+    return "/ndn/{0}-site/{0}/svs_chat/{0}".format(node.name)
+
+def start_chat(node, point):
+    """
+    Start the chat application of point on node, returning its Popen
     """
-    Wrapper class to run the chat application from each node
+    logpath = point.getLogPath()
+    log_ext = "bin" if EVLOG_DECODE else "log"
+    args = [point.sync_exec, get_svs_identity(node),
+            "{}/{}.{}".format(logpath, node.name, log_ext), str(point.pub_timing)]
+    if THREADED:
+        args += ["mt", str(APP_BUSY_US)]
+    if DEBUG_GDB:
+        args = ["gdb", "-batch", "-ex", "run", "-ex=set confirm off", "-ex", "bt full",
+                "-ex", "quit", "--args"] + args
+
+    # HOME points the tools at the node's NFD (its client.conf)
+    env = dict(os.environ,
+               HOME=node.params['params']['homeDir'],
+               EVAL_SYNC_PREFIX=point.prefix,
+               EVAL_WARMUP=str(WARMUP_S),
+               EVAL_MEASURE=str(MEASURE_S),
+               EVAL_DRAIN=str(DRAIN_S),
+               EVAL_NODES=str(NUM_NODES if EARLY_EXIT else 0))
+
+    with open("{}/stdout/{}.log".format(logpath, node.name), "w") as out, \
+         open("{}/stderr/{}.log".format(logpath, node.name), "w") as err:
+        proc = node.popen(args, stdout=out, stderr=err, env=env)
+    info("[{}] running {} == {}\n".format(node.name, " ".join(args), proc.pid))
+    return proc
+
+def read_state():
+    if os.path.exists(SWEEP_STATE):
+        with open(SWEEP_STATE) as f:
+            return json.load(f)
+    return {"done": []}
+
+def write_state(state):
+    tmp = SWEEP_STATE + ".tmp"
+    with open(tmp, "w") as f:
+        json.dump(state, f, indent=1)
+    os.replace(tmp, SWEEP_STATE)
+
+def start_point(ndn, point, slot, free_hosts, done):
     """
-    def get_svs_identity(self):
-        return "/ndn/{0}-site/{0}/svs_chat/{0}".format(self.node.name)
-
-    def start(self):
-        exe = SYNC_EXEC
-        identity = self.get_svs_identity()
-
-        if DEBUG_GDB:
-            run_cmd = "gdb -batch -ex run -ex=\"set confirm off\" -ex \"bt full\" -ex quit --args {0} {1} {2}/{3}.log {4} >{2}/stdout/{3}.log 2>{2}/stderr/{3}.log &".format(
-                exe, identity, getLogPath(), self.node.name, PUB_TIMING)
-        else:
-            run_cmd = "{0} {1} {2}/{3}.log {4} >{2}/stdout/{3}.log 2>{2}/stderr/{3}.log &".format(
-                exe, identity, getLogPath(), self.node.name, PUB_TIMING)
-
-        ret = self.node.cmd(run_cmd)
-        info("[{}] running {} == {}\n".format(self.node.name, run_cmd, ret))
-
-def count_running(pids):
-    return sum(psutil.pid_exists(pid) for pid in pids)
-
-def get_pids():
-    pids = []
-    for proc in psutil.process_iter():
-        try:
-            pinfo = proc.as_dict(attrs=['pid', 'name', 'create_time'])
-            # Check if process name contains the given name string.
-            if ("gdb" if DEBUG_GDB else "eval") in pinfo['name'].lower():
-                pids.append(pinfo['pid'])
-        except (psutil.NoSuchProcess, psutil.AccessDenied, psutil.ZombieProcess):
-            pass
-    return pids
+    Start point on NUM_NODES of free_hosts; once all of its applications
+    have exited (point, slot) is put on done
+    """
+    # a partial log of an interrupted sweep
+    if os.path.exists(point.logpath):
+        shutil.rmtree(point.logpath)
+
+    point.hosts = random.Random(point.run_number).sample(free_hosts, NUM_NODES)
+
+    if PARALLEL_POINTS == 1:
+        point.prefix = "/ndn/svs"
+        # Clear content store
+        for node in ndn.net.hosts:
+            cmd = 'nfdc cs erase /'
+            node.cmd(cmd)
+
+            with open("{}/report-start-{}.status".format(point.getLogPath(), node.name), "w") as f:
+                f.write(node.cmd('nfdc status report'))
+    else:
+        point.prefix = "/ndn/svs/{}".format(slot)
+        # Clear content store of this point's sync prefix and the names of
+        # its hosts, which no running point uses
+        names = [point.prefix] + ["/ndn/{}-site".format(h.name) for h in point.hosts]
+        cmd = "; ".join("nfdc cs erase {}".format(n) for n in names)
+        for node in ndn.net.hosts:
+            node.cmd(cmd)
+
+    time.sleep(1)
+
+    procs = [start_chat(node, point) for node in point.hosts]
+
+    def wait():
+        for proc in procs:
+            proc.wait()
+        done.put((point, slot))
+
+    threading.Thread(target=wait, daemon=True).start()
+
+def finish_point(ndn, point):
+    if PARALLEL_POINTS == 1:
+        for node in ndn.net.hosts:
+            with open("{}/report-end-{}.status".format(point.getLogPath(), node.name), "w") as f:
+                f.write(node.cmd('nfdc status report'))
+
+    if EVLOG_DECODE:
+        for node in point.hosts:
+            logfile = "{}/{}".format(point.getLogPath(), node.name)
+            os.system("{0} {1}.bin > {1}.log".format(EVLOG_DECODE, logfile))
+
+    if EVSTORE:
+        logpath = point.getLogPath()
+        protocol = os.path.basename(os.path.normpath(point.log_main_directory))
+        count = evstore.write_run(logpath, logpath + ".parquet", protocol, point.pub_timing, point.run_number)
+        info("Stored {} events in {}.parquet\n".format(count, logpath))
+        if not EVSTORE_KEEP_LOGS:
+            for f in evstore.run_files(logpath):
+                os.remove(f)
 
 if __name__ == '__main__':
     print(LOG_PREFIX, TOPO_FILE, SYNC_EXEC_VALS)
@@ -158,47 +269,40 @@ if __name__ == '__main__':
     info('Sleeping 10 seconds\n')
     time.sleep(3 if DEBUG_GDB else 10)
 
+    state = read_state()
+    points = []
     for exec_i, sync_exec in enumerate(SYNC_EXEC_VALS):
         for pub_timing in PUB_TIMING_VALS:
             for run_number in RUN_NUMBER_VALS:
-                # Set globals
-                RUN_NUMBER = run_number
-                PUB_TIMING = pub_timing
-                SYNC_EXEC = sync_exec
-                LOG_MAIN_DIRECTORY = LOG_MAIN_DIRECTORY_VALS[exec_i]
-
-                # Clear content store
-                for node in ndn.net.hosts:
-                    cmd = 'nfdc cs erase /'
-                    node.cmd(cmd)
-
-                    with open("{}/report-start-{}.status".format(getLogPath(), node.name), "w") as f:
-                        f.write(node.cmd('nfdc status report'))
-
-                time.sleep(1)
-
-                random.seed(RUN_NUMBER)
-                allowed_hosts = [x for x in ndn.net.hosts if len(x.intfList()) < 8]
-                pub_hosts = random.sample(allowed_hosts, NUM_NODES)
-
-                # ================= SVS BEGIN ====================================
-
-                # identity_app = AppManager(ndn, pub_hosts, IdentityApplication)
-                svs_chat_app = AppManager(ndn, pub_hosts, SvsChatApplication)
-
-                # =================== SVS END ====================================
-
-                pids = get_pids()
-                info("pids: {}\n".format(pids))
-                count = count_running(pids)
-                while count > 0:
-                    info("{} nodes are runnning\n".format(count))
-                    time.sleep(5)
-                    count = count_running(pids)
-
-                for node in ndn.net.hosts:
-                    with open("{}/report-end-{}.status".format(getLogPath(), node.name), "w") as f:
-                        f.write(node.cmd('nfdc status report'))
+                point = Point(sync_exec, LOG_MAIN_DIRECTORY_VALS[exec_i], pub_timing, run_number)
+                if point.logpath in state["done"]:
+                    info("Skipping {}, done\n".format(point.logpath))
+                    continue
+                points.append(point)
+
+    allowed_hosts = [x for x in ndn.net.hosts if len(x.intfList()) < 8]
+    if PARALLEL_POINTS > len(allowed_hosts) // NUM_NODES:
+        PARALLEL_POINTS = max(1, len(allowed_hosts) // NUM_NODES)
+        info("Only {} hosts, running {} points at a time\n".format(len(allowed_hosts), PARALLEL_POINTS))
+    done = queue.Queue()
+    running = {}
+    while points or running:
+        # Start points while there are slots and hosts for them
+        busy = set(h for p in running.values() for h in p.hosts)
+        free_hosts = [x for x in allowed_hosts if x not in busy]
+        if points and len(running) < PARALLEL_POINTS and len(free_hosts) >= NUM_NODES:
+            slot = min(set(range(PARALLEL_POINTS)) - set(running))
+            running[slot] = points.pop(0)
+            start_point(ndn, running[slot], slot, free_hosts, done)
+            info("{} points running, {} to go\n".format(len(running), len(points)))
+            continue
+
+        point, slot = done.get()
+        del running[slot]
+        finish_point(ndn, point)
+
+        state["done"].append(point.logpath)
+        write_state(state)
 
     ndn.stop()
 
@@ -22,6 +22,7 @@
 #include <ndn-svs/svsync-base.hpp>
 
 #include "log.hpp"
+#include "threads.hpp"
 
 int m_stateVectorLogIntervalInMilliseconds = 1000;
 
@@ -33,6 +34,11 @@ public:
 public:
   std::string prefix;
   std::string m_id;
+  std::string logfile;
+  // run sync, the application and logging on separate threads
+  bool threaded = false;
+  // microseconds of application work per update received
+  int appBusyUs = 0;
 };
 
 class Program
@@ -40,7 +46,7 @@ class Program
 public:
   Program(const Options &options)
     : m_options(options)
-    , m_scheduler(face.getIoService())
+    , m_scheduler(m_options.threaded ? m_appIo : face.getIoService())
     , m_rng(ndn::random::getRandomNumberEngine())
     , m_sleepTime(averageTimeBetweenPublishesInMilliseconds - varianceInTimeBetweenPublishesInMilliseconds, averageTimeBetweenPublishesInMilliseconds + varianceInTimeBetweenPublishesInMilliseconds)
   {
@@ -52,47 +58,76 @@ public:
   run()
   {
     BOOST_LOG_TRIVIAL(info) << "NODE_INIT::" << m_options.m_id;
-    face.processEvents();
+    if (!m_options.threaded) {
+      face.processEvents();
+      return;
+    }
+
+    // sync runs on this thread, the application on appThread
+    m_log.start();
+    boost::asio::io_service::work appWork(m_appIo);
+    std::thread appThread([this] { m_appIo.run(); });
+    face.processEvents(ndn::time::milliseconds::zero(), true);
+    m_appIo.stop();
+    appThread.join();
+    m_log.stop();
   }
 
   void
   runIter()
   {
-    if (start_time == 0) {
-      start_time = static_cast<long int> (time(NULL));
+    auto curr_time = std::chrono::steady_clock::now();
+    if (start_time == std::chrono::steady_clock::time_point()) {
+      start_time = curr_time;
     }
+    auto phase = m_phases.at(curr_time - start_time);
 
-    long int curr_time = static_cast<long int> (time(NULL));
-
-    if (curr_time - start_time <= 120) {
+    if (phase == Phases::WARMUP || phase == Phases::MEASURE) {
       curr_i++;
       std::ostringstream ss = std::ostringstream();
       ss << m_options.m_id << "=" << curr_i;
       std::string message = ss.str();
-      publishMsg(message);
-      BOOST_LOG_TRIVIAL(info) << "PUBL_MSG::" << m_options.m_id << "::" << message;
+      // receivers that fetch the content can tell how long it took
+      publishMsg(message + "::" + std::to_string(evlog::steadyNs()));
+      m_log.event(evlog::PUBL_MSG, m_options.m_id, curr_i);
+      m_phases.published();
     }
 
-    if (curr_time - start_time <= 120 + 30) {
-      m_scheduler.schedule(ndn::time::milliseconds(m_sleepTime(m_rng)),
+    if (phase != Phases::DONE) {
+      int sleepMs = m_sleepTime(m_rng);
+      // all that's left to do is notice that the nodes have converged
+      if (phase == Phases::DRAIN && m_phases.earlyExit()) {
+        sleepMs = std::min(sleepMs, 1000);
+      }
+      m_scheduler.schedule(ndn::time::milliseconds(sleepMs),
                            [this] { runIter(); });
       return;
     }
 
-    m_svs.reset();
-    face.shutdown();
+    onFace([this] {
+      m_svs.reset();
+      face.shutdown();
+    });
   }
 
 protected:
   void
   onMissingData(const std::vector<ndn::svs::MissingDataInfo>& v)
+  {
+    onApp([this, v] { processMissingData(v); });
+  }
+
+  void
+  processMissingData(const std::vector<ndn::svs::MissingDataInfo>& v)
   {
     for (size_t i = 0; i < v.size(); i++)
     {
       for (ndn::svs::SeqNo s = v[i].low; s <= v[i].high; ++s)
       {
         ndn::svs::NodeID nid = v[i].session;
-        BOOST_LOG_TRIVIAL(info) << "RECV_STATE::" << nid << "::" << s;
+        spinFor(m_options.appBusyUs);
+        m_log.event(evlog::RECV_STATE, nid, s);
+        m_phases.received(nid, s);
         /* m_svs->fetchData(nid, s, [&] (const ndn::Data& data)
           {
             size_t data_size = data.getContent().value_size();
@@ -106,28 +141,56 @@ protected:
   void
   publishMsg(std::string msg)
   {
-    m_svs->publishData(reinterpret_cast<const uint8_t*>(msg.c_str()),
-                       msg.size(),
-                       ndn::time::milliseconds(1000));
+    onFace([this, msg] {
+      m_svs->publishData(reinterpret_cast<const uint8_t*>(msg.c_str()),
+                         msg.size(),
+                         ndn::time::milliseconds(1000));
+    });
+  }
+
+  // run 'f' on the sync (face) thread
+  void
+  onFace(std::function<void()> f)
+  {
+    if (m_options.threaded)
+      m_toFace.post(std::move(f));
+    else
+      f();
+  }
+
+  // run 'f' on the application thread
+  void
+  onApp(std::function<void()> f)
+  {
+    if (m_options.threaded)
+      m_toApp.post(std::move(f));
+    else
+      f();
   }
 
 public:
   const Options m_options;
   ndn::Face face;
   std::shared_ptr<ndn::svs::SVSyncBase> m_svs;
+  // application thread's io_service (only used if threaded)
+  boost::asio::io_service m_appIo;
   ndn::Scheduler m_scheduler;
+  TaskQueue m_toFace{face.getIoService()};
+  TaskQueue m_toApp{m_appIo};
+  AsyncLog m_log;
+  Phases m_phases{m_options.logfile};
 
   ndn::random::RandomNumberEngine& m_rng;
   std::uniform_int_distribution<> m_sleepTime;
 
-  long int start_time = 0;
+  std::chrono::steady_clock::time_point start_time;
   int curr_i = 0;
 };
 
 template <typename T>
 int
 callMain(int argc, char **argv) {
-  if (argc != 4) {
+  if (argc < 4 || argc > 6) {
     BOOST_LOG_TRIVIAL(error) << "WRONG_ARGS";
     exit(1);
   }
@@ -136,8 +199,12 @@ callMain(int argc, char **argv) {
   varianceInTimeBetweenPublishesInMilliseconds = averageTimeBetweenPublishesInMilliseconds / 5;
 
   Options opt;
-  opt.prefix = "/ndn/svs";
+  opt.prefix = syncPrefix();
   opt.m_id = argv[1];
+  opt.logfile = argv[2];
+  // optional "mt" [app busy us]: multi-threaded mode
+  opt.threaded = argc > 4 && std::string(argv[4]) == "mt";
+  opt.appBusyUs = argc > 5 ? strtol(argv[5], NULL, 10) : 0;
 
   initlogger(std::string(argv[2]));
 
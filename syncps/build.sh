@@ -1,3 +1,3 @@
-g++ eval.cpp -o ../eval -DBOOST_LOG_DYN_LINK --std=c++14 \
+g++ eval.cpp -o ../eval -DBOOST_LOG_DYN_LINK --std=c++17 \
                      -lboost_system -lboost_log_setup -lboost_log -lboost_thread \
-                     -lboost_iostreams -lpthread -lndn-cxx
+                     -lz -lpthread -lndn-cxx
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_CODEC_HPP
+#define SYNCPS_CODEC_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <zlib.h>
+#ifdef SYNCPS_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef SYNCPS_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+/*
+ * Block compression used for the IBLT carried in sync interest names.
+ *
+ * All routines work on caller supplied buffers so an encode or decode
+ * is a single pass between the wire bytes and the table. zlib is always
+ * available; zstd and lz4 are compiled in when SYNCPS_HAVE_ZSTD or
+ * SYNCPS_HAVE_LZ4 are defined (and -lzstd / -llz4 are linked).
+ */
+
+namespace syncps {
+
+enum class Compression : uint8_t { none = 0, zlib = 1, zstd = 2, lz4 = 3 };
+
+class CodecError : public std::runtime_error
+{
+  public:
+    using std::runtime_error::runtime_error;
+};
+
+static inline const char* toString(Compression c)
+{
+    switch (c) {
+    case Compression::none: return "none";
+    case Compression::zlib: return "zlib";
+    case Compression::zstd: return "zstd";
+    case Compression::lz4:  return "lz4";
+    }
+    return "unknown";
+}
+
+static inline bool isSupported(Compression c) noexcept
+{
+    switch (c) {
+    case Compression::none:
+    case Compression::zlib:
+        return true;
+    case Compression::zstd:
+#ifdef SYNCPS_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    case Compression::lz4:
+#ifdef SYNCPS_HAVE_LZ4
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+static inline void putLE32(uint8_t* p, uint32_t v) noexcept
+{
+    p[0] = 0xFF & v;
+    p[1] = 0xFF & (v >> 8);
+    p[2] = 0xFF & (v >> 16);
+    p[3] = 0xFF & (v >> 24);
+}
+
+static inline uint32_t getLE32(const uint8_t* p) noexcept
+{
+    return (uint32_t(p[3]) << 24) | (uint32_t(p[2]) << 16) |
+           (uint32_t(p[1]) << 8) | uint32_t(p[0]);
+}
+
+/**
+ * @brief LEB128 varint routines used by the sparse IBLT layout
+ */
+static constexpr size_t MAX_VARINT32 = 5;
+
+static inline uint8_t* putVarint(uint8_t* p, uint32_t v) noexcept
+{
+    while (v >= 0x80) {
+        *p++ = uint8_t(v) | 0x80;
+        v >>= 7;
+    }
+    *p++ = uint8_t(v);
+    return p;
+}
+
+/**
+ * @return pointer past the varint or nullptr if it runs past 'end'
+ */
+static inline const uint8_t* getVarint(const uint8_t* p, const uint8_t* end,
+                                       uint32_t& v) noexcept
+{
+    v = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        v |= uint32_t(b & 0x7F) << shift;
+        if ((b & 0x80) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+static inline uint32_t zigzag(int32_t v) noexcept
+{
+    return (uint32_t(v) << 1) ^ uint32_t(v >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t v) noexcept
+{
+    return int32_t(v >> 1) ^ -int32_t(v & 1);
+}
+
+/**
+ * @brief upper bound on the compressed size of 'len' bytes
+ */
+static inline size_t maxCompressedSize(Compression c, size_t len)
+{
+    switch (c) {
+    case Compression::none:
+        return len;
+    case Compression::zlib:
+        return compressBound(len);
+#ifdef SYNCPS_HAVE_ZSTD
+    case Compression::zstd:
+        return ZSTD_compressBound(len);
+#endif
+#ifdef SYNCPS_HAVE_LZ4
+    case Compression::lz4:
+        return LZ4_compressBound(len);
+#endif
+    default:
+        break;
+    }
+    throw CodecError(std::string("compression not supported: ") + toString(c));
+}
+
+/**
+ * @brief compress 'len' bytes at 'in' into 'out'
+ *
+ * @param cap size of 'out'; must be at least maxCompressedSize(c, len)
+ * @return number of bytes written to 'out'
+ * @throws CodecError if the compressor fails
+ */
+static inline size_t compressBlock(Compression c, const uint8_t* in, size_t len,
+                                   uint8_t* out, size_t cap)
+{
+    switch (c) {
+    case Compression::none:
+        if (cap < len) {
+            break;
+        }
+        std::memcpy(out, in, len);
+        return len;
+    case Compression::zlib: {
+        uLongf outLen = cap;
+        if (compress2(out, &outLen, in, len, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            break;
+        }
+        return outLen;
+    }
+#ifdef SYNCPS_HAVE_ZSTD
+    case Compression::zstd: {
+        auto n = ZSTD_compress(out, cap, in, len, 1);
+        if (ZSTD_isError(n)) {
+            break;
+        }
+        return n;
+    }
+#endif
+#ifdef SYNCPS_HAVE_LZ4
+    case Compression::lz4: {
+        auto n = LZ4_compress_default((const char*)in, (char*)out, len, cap);
+        if (n <= 0) {
+            break;
+        }
+        return n;
+    }
+#endif
+    default:
+        break;
+    }
+    throw CodecError(std::string("compress failed: ") + toString(c));
+}
+
+/**
+ * @brief decompress 'len' bytes at 'in' into exactly 'outLen' bytes at 'out'
+ *
+ * @throws CodecError if the input is corrupt or doesn't expand to outLen
+ */
+static inline void decompressBlock(Compression c, const uint8_t* in, size_t len,
+                                   uint8_t* out, size_t outLen)
+{
+    switch (c) {
+    case Compression::none:
+        if (len != outLen) {
+            break;
+        }
+        std::memcpy(out, in, len);
+        return;
+    case Compression::zlib: {
+        uLongf n = outLen;
+        if (uncompress(out, &n, in, len) != Z_OK || n != outLen) {
+            break;
+        }
+        return;
+    }
+#ifdef SYNCPS_HAVE_ZSTD
+    case Compression::zstd: {
+        auto n = ZSTD_decompress(out, outLen, in, len);
+        if (ZSTD_isError(n) || n != outLen) {
+            break;
+        }
+        return;
+    }
+#endif
+#ifdef SYNCPS_HAVE_LZ4
+    case Compression::lz4: {
+        auto n = LZ4_decompress_safe((const char*)in, (char*)out, len, outLen);
+        if (n < 0 || size_t(n) != outLen) {
+            break;
+        }
+        return;
+    }
+#endif
+    default:
+        break;
+    }
+    throw CodecError(std::string("decompress failed: ") + toString(c));
+}
+
+/**
+ * @brief per-thread scratch buffer reused across encodes and decodes
+ */
+static inline std::vector<uint8_t>& codecScratch(size_t len)
+{
+    static thread_local std::vector<uint8_t> buf;
+    if (buf.size() < len) {
+        buf.resize(len);
+    }
+    return buf;
+}
+
+}  // namespace syncps
+
+#endif  // SYNCPS_CODEC_HPP
@@ -15,6 +15,7 @@
 #include <string>
 
 #include "log.hpp"
+#include "threads.hpp"
 
 int averageTimeBetweenPublishesInMilliseconds = 5000;
 int varianceInTimeBetweenPublishesInMilliseconds = 1000;
@@ -31,18 +32,22 @@ public:
    * Set syncInterestLifetime and syncReplyFreshness to 1.6 seconds
    * userPrefix is the default user prefix, no updates are published on it in this example
    */
-  Producer(const std::string& userPrefix)
+  Producer(const std::string& userPrefix, const std::string& logfile,
+           bool threaded = false, int appBusyUs = 0)
     : m_userPrefix(userPrefix)
-    , m_scheduler(m_face.getIoService())
+    , m_threaded(threaded)
+    , m_appBusyUs(appBusyUs)
+    , m_scheduler(m_threaded ? m_appIo : m_face.getIoService())
+    , m_phases(logfile)
     , m_sync(std::make_shared<syncps::SyncPubsub>(
-        m_face, "/ndn/svs", isExpired, filterPubs, 1000_ms))
+        m_face, syncPrefix(), isExpired, filterPubs, 1000_ms))
     , m_rng(ndn::random::getRandomNumberEngine())
     , m_sleepTime(averageTimeBetweenPublishesInMilliseconds - varianceInTimeBetweenPublishesInMilliseconds, averageTimeBetweenPublishesInMilliseconds + varianceInTimeBetweenPublishesInMilliseconds)
   {
     m_scheduler.schedule(ndn::time::milliseconds(m_sleepTime(m_rng)),
                          [this] { runIter(); });
     m_sync->subscribeTo(
-      ndn::Name("/ndn/svs"),
+      ndn::Name(syncPrefix()),
       std::bind(&Producer::processSyncUpdate, this, _1)
     );
   }
@@ -79,38 +84,57 @@ public:
   run()
   {
     BOOST_LOG_TRIVIAL(info) << "NODE_INIT::" << m_userPrefix;
-    m_face.processEvents();
+    if (!m_threaded) {
+      m_face.processEvents();
+      return;
+    }
+
+    // sync runs on this thread, the application on appThread
+    m_log.start();
+    boost::asio::io_service::work appWork(m_appIo);
+    std::thread appThread([this] { m_appIo.run(); });
+    m_face.processEvents(ndn::time::milliseconds::zero(), true);
+    m_appIo.stop();
+    appThread.join();
+    m_log.stop();
   }
 
   void
   runIter()
   {
-    if (start_time == 0) {
-      start_time = static_cast<long int> (time(NULL));
+    auto curr_time = std::chrono::steady_clock::now();
+    if (start_time == std::chrono::steady_clock::time_point()) {
+      start_time = curr_time;
     }
+    auto phase = m_phases.at(curr_time - start_time);
 
-    long int curr_time = static_cast<long int> (time(NULL));
-
-    if (curr_time - start_time <= 120) {
+    if (phase == Phases::WARMUP || phase == Phases::MEASURE) {
       curr_i++;
       std::ostringstream ss = std::ostringstream();
       ss << m_userPrefix << "::" << curr_i;
+      ss << "::" << evlog::steadyNs();
       std::string message = ss.str();
       publishMsg(message);
-
-      std::ostringstream ss1 = std::ostringstream();
-      ss1 << m_userPrefix << "=" << curr_i;
-      BOOST_LOG_TRIVIAL(info) << "PUBL_MSG::" << m_userPrefix << "::" << ss1.str();
+      m_log.event(evlog::PUBL_MSG, m_userPrefix, curr_i);
+      m_phases.published();
     }
 
-    if (curr_time - start_time <= 120 + 30) {
-      m_scheduler.schedule(ndn::time::milliseconds(m_sleepTime(m_rng)),
+    if (phase != Phases::DONE) {
+      int sleepMs = m_sleepTime(m_rng);
+      // all that's left to do is notice that the nodes have converged
+      if (phase == Phases::DRAIN && m_phases.earlyExit()) {
+        sleepMs = std::min(sleepMs, 1000);
+      }
+      m_scheduler.schedule(ndn::time::milliseconds(sleepMs),
                            [this] { runIter(); });
       return;
     }
 
-    m_sync.reset();
-    m_face.shutdown();
+    onFace([this] {
+      BOOST_LOG_TRIVIAL(info) << "SYNC_COUNTERS::" << m_sync->getCounters();
+      m_sync.reset();
+      m_face.shutdown();
+    });
   }
 
 private:
@@ -126,9 +150,11 @@ private:
   void
   publishMsg(std::string msg)
   {
-    auto cmd(buildCmd("/ndn/svs", "test2"));
-    cmd.setContent(reinterpret_cast<const uint8_t*>(msg.c_str()), msg.size());
-    m_sync->publish(std::move(cmd));
+    onFace([this, msg] {
+      auto cmd(buildCmd(syncPrefix(), "test2"));
+      cmd.setContent(reinterpret_cast<const uint8_t*>(msg.c_str()), msg.size());
+      m_sync->publish(std::move(cmd));
+    });
   }
 
   void
@@ -137,15 +163,58 @@ private:
     size_t data_size = publication.getContent().value_size();
     std::string content_str((char *)publication.getContent().value(), data_size);
 
-    BOOST_LOG_TRIVIAL(info) << "RECV_STATE::" << content_str;
+    onApp([this, content_str] {
+      spinFor(m_appBusyUs);
+      // the content is <prefix>::<seq>::<publish ns> (see runIter)
+      auto nsSep = content_str.rfind("::");
+      auto seqSep = nsSep == 0 || nsSep == std::string::npos ?
+                    std::string::npos : content_str.rfind("::", nsSep - 1);
+      if (seqSep == std::string::npos) {
+        m_log.line() << "RECV_STATE::" << content_str;
+        return;
+      }
+      auto node = content_str.substr(0, seqSep);
+      auto seq = strtoull(content_str.c_str() + seqSep + 2, NULL, 10);
+      m_log.event(evlog::RECV_STATE, node, seq,
+                  strtoull(content_str.c_str() + nsSep + 2, NULL, 10));
+      m_phases.received(node, seq);
+    });
+  }
+
+  // run 'f' on the sync (face) thread
+  void
+  onFace(std::function<void()> f)
+  {
+    if (m_threaded)
+      m_toFace.post(std::move(f));
+    else
+      f();
+  }
+
+  // run 'f' on the application thread
+  void
+  onApp(std::function<void()> f)
+  {
+    if (m_threaded)
+      m_toApp.post(std::move(f));
+    else
+      f();
   }
 
 private:
   std::string m_userPrefix;
+  bool m_threaded;
+  int m_appBusyUs;
   ndn::Face m_face;
+  // application thread's io_service (only used if threaded)
+  boost::asio::io_service m_appIo;
   ndn::Scheduler m_scheduler;
+  TaskQueue m_toFace{m_face.getIoService()};
+  TaskQueue m_toApp{m_appIo};
+  AsyncLog m_log;
+  Phases m_phases;
 
-  long int start_time = 0;
+  std::chrono::steady_clock::time_point start_time;
   int curr_i = 0;
 
   std::shared_ptr<syncps::SyncPubsub> m_sync;
@@ -157,7 +226,7 @@ private:
 int
 main(int argc, char* argv[])
 {
-  if (argc != 4) {
+  if (argc < 4 || argc > 6) {
     BOOST_LOG_TRIVIAL(error) << "WRONG_ARGS";
     exit(1);
   }
@@ -168,7 +237,9 @@ main(int argc, char* argv[])
   initlogger(std::string(argv[2]));
 
   try {
-    Producer producer(argv[1]);
+    // optional "mt" [app busy us]: multi-threaded mode
+    Producer producer(argv[1], argv[2], argc > 4 && std::string(argv[4]) == "mt",
+                      argc > 5 ? strtol(argv[5], NULL, 10) : 0);
     producer.run();
   }
   catch (const std::exception& e) {}
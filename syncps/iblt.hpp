@@ -47,24 +47,24 @@
 #ifndef SYNCPS_IBLT_HPP
 #define SYNCPS_IBLT_HPP
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
 #include <inttypes.h>
 #include <iomanip>
 #include <iostream>
-#include <set>
+#include <optional>
 #include <sstream>
 #include <string>
 #include <vector>
 
-#include <boost/iostreams/copy.hpp>
-#include <boost/iostreams/device/array.hpp>
-#include <boost/iostreams/filter/zlib.hpp>
-#include <boost/iostreams/filtering_stream.hpp>
 #include <ndn-cxx/name.hpp>
 
-namespace syncps {
+#include "codec.hpp"
+#include "simd.hpp"
 
-namespace bio = boost::iostreams;
+namespace syncps {
 
 static constexpr size_t N_HASH(3);
 static constexpr size_t N_HASHCHECK(11);
@@ -80,30 +80,48 @@ static inline uint32_t ROTL32(uint32_t x, int8_t r)
     return (x << r) | (x >> (32 - r));
 }
 
-static inline uint32_t murmurHash3(uint32_t nHashSeed,
-                     const std::vector<unsigned char>& vDataToHash)
+static inline uint32_t murmurMix(uint32_t k1)
 {
-    uint32_t h1 = nHashSeed;
-    const uint32_t c1 = 0xcc9e2d51;
-    const uint32_t c2 = 0x1b873593;
-    const size_t nblocks = vDataToHash.size() / 4;
-    const uint32_t* blocks = (const uint32_t*)(&vDataToHash[0] + nblocks * 4);
+    k1 *= 0xcc9e2d51;
+    k1 = ROTL32(k1, 15);
+    k1 *= 0x1b873593;
+    return k1;
+}
 
-    for (size_t i = -nblocks; i; i++) {
-        uint32_t k1 = blocks[i];
+static inline uint32_t murmurFinal(uint32_t h1, size_t len)
+{
+    h1 ^= len;
+    h1 ^= h1 >> 16;
+    h1 *= 0x85ebca6b;
+    h1 ^= h1 >> 13;
+    h1 *= 0xc2b2ae35;
+    h1 ^= h1 >> 16;
+    return h1;
+}
 
-        k1 *= c1;
-        k1 = ROTL32(k1, 15);
-        k1 *= c2;
+/*
+ * Hash 'len' bytes starting at 'data'. This is the primitive all the
+ * other overloads use; it never allocates so it can be applied directly
+ * to packet wire encodings and name components.
+ */
+static inline uint32_t murmurHash3(uint32_t nHashSeed, const uint8_t* data,
+                                   size_t len)
+{
+    uint32_t h1 = nHashSeed;
+    const size_t nblocks = len / 4;
 
-        h1 ^= k1;
+    for (size_t i = 0; i < nblocks; i++) {
+        uint32_t k1;
+        std::memcpy(&k1, data + i * 4, sizeof(k1));
+
+        h1 ^= murmurMix(k1);
         h1 = ROTL32(h1, 13);
         h1 = h1 * 5 + 0xe6546b64;
     }
 
-    const uint8_t* tail = (const uint8_t*)(&vDataToHash[0] + nblocks * 4);
+    const uint8_t* tail = data + nblocks * 4;
     uint32_t k1 = 0;
-    switch (vDataToHash.size() & 3) {
+    switch (len & 3) {
     case 3:
         k1 ^= tail[2] << 16;
         NDN_CXX_FALLTHROUGH;
@@ -112,31 +130,32 @@ static inline uint32_t murmurHash3(uint32_t nHashSeed,
         NDN_CXX_FALLTHROUGH;
     case 1:
         k1 ^= tail[0];
-        k1 *= c1;
-        k1 = ROTL32(k1, 15);
-        k1 *= c2;
-        h1 ^= k1;
+        h1 ^= murmurMix(k1);
     }
-    h1 ^= vDataToHash.size();
-    h1 ^= h1 >> 16;
-    h1 *= 0x85ebca6b;
-    h1 ^= h1 >> 13;
-    h1 *= 0xc2b2ae35;
-    h1 ^= h1 >> 16;
-    return h1;
+    return murmurFinal(h1, len);
+}
+
+static inline uint32_t murmurHash3(uint32_t nHashSeed,
+                                   const std::vector<unsigned char>& vDataToHash)
+{
+    return murmurHash3(nHashSeed, vDataToHash.data(), vDataToHash.size());
 }
 
 static inline uint32_t murmurHash3(uint32_t nHashSeed, const std::string& str)
 {
-    return murmurHash3(nHashSeed,
-                       std::vector<unsigned char>(str.begin(), str.end()));
+    return murmurHash3(nHashSeed, (const uint8_t*)str.data(), str.size());
 }
 
+/*
+ * Fixed-width path for IBLT keys: a single 4-byte block and no tail.
+ * Gives the same result as hashing the key's in-memory bytes.
+ */
 static inline uint32_t murmurHash3(uint32_t nHashSeed, uint32_t value)
 {
-    return murmurHash3(nHashSeed,
-        std::vector<unsigned char>((unsigned char*)&value,
-                                   (unsigned char*)&value + sizeof(uint32_t)));
+    uint32_t h1 = nHashSeed ^ murmurMix(value);
+    h1 = ROTL32(h1, 13);
+    h1 = h1 * 5 + 0xe6546b64;
+    return murmurFinal(h1, sizeof(value));
 }
 
 class HashTableEntry
@@ -168,12 +187,24 @@ static inline std::ostream& operator<<(std::ostream& out, const HashTableEntry&
  * @brief Invertible Bloom Lookup Table (Invertible Bloom Filter)
  *
  * Used by Partial Sync (PartialProducer) and Full Sync (Full Producer)
+ *
+ * The table is stored as a structure of arrays (one array each for the
+ * cells' count, keySum and keyCheck) so subtraction and comparison of
+ * whole tables run as vector kernels (see simd.hpp). HashTableEntry is
+ * the by-value view of one cell.
  */
 class IBLT
 {
   private:
     static constexpr int INSERT = 1;
     static constexpr int ERASE = -1;
+    static constexpr size_t CELL_SIZE = 12;   // count, keySum, keyCheck
+    // bytes per cell in the sparse layout: two varints + keySum + keyCheck
+    static constexpr size_t MIN_SPARSE_CELL = 1 + 1 + 8;
+    static constexpr size_t MAX_SPARSE_CELL = 2 * MAX_VARINT32 + 8;
+    static constexpr uint8_t SPARSE = 0x80;   // format code flag
+    // largest table accepted from a peer
+    static constexpr size_t MAX_CELLS = N_HASH * 65536;
 
   public:
     class Error : public std::runtime_error
@@ -188,6 +219,14 @@ class IBLT
      * @param expectedNumEntries the expected number of entries in the IBLT
      */
     explicit IBLT(size_t expectedNumEntries)
+    {
+        resize(cellsFor(expectedNumEntries));
+    }
+
+    /**
+     * @brief number of cells in an IBLT for 'expectedNumEntries' entries
+     */
+    static size_t cellsFor(size_t expectedNumEntries) noexcept
     {
         // 1.5x expectedNumEntries gives very low probability of decoding failure
         size_t nEntries = expectedNumEntries + expectedNumEntries / 2;
@@ -196,34 +235,114 @@ class IBLT
         if (remainder != 0) {
             nEntries += (N_HASH - remainder);
         }
-        m_hashTable.resize(nEntries);
+        return nEntries;
     }
 
-    IBLT(const std::vector<HashTableEntry>& hashTable) : m_hashTable(hashTable) {}
+    /**
+     * @brief an empty IBLT with exactly 'nCells' cells
+     *
+     * @param nCells table size (a multiple of N_HASH)
+     */
+    static IBLT withCells(size_t nCells)
+    {
+        BOOST_ASSERT(nCells % N_HASH == 0);
+        IBLT iblt(0);
+        iblt.resize(nCells);
+        return iblt;
+    }
+
+    IBLT(const std::vector<HashTableEntry>& hashTable)
+    {
+        resize(hashTable.size());
+        for (size_t i = 0; i < hashTable.size(); i++) {
+            m_count[i] = hashTable[i].count;
+            m_keySum[i] = hashTable[i].keySum;
+            m_keyCheck[i] = hashTable[i].keyCheck;
+        }
+    }
 
     /**
-     * @brief Populate the hash table using the vector representation of IBLT
+     * @brief Populate the hash table from its name component encoding
+     *
+     * The cells are decoded directly from the (decompressed) wire bytes.
+     * The encoding carries the table size and this IBLT is resized to
+     * match it. (Tables in the legacy encoding must be our size.)
      *
      * @param ibltName the Component representation of IBLT
-     * @throws Error if size of values is not compatible with this IBF
+     * @throws Error if the encoding is corrupt or its size is invalid
      */
     void initialize(const ndn::name::Component& ibltName)
     {
-        const auto& values = extractValueFromName(ibltName);
-
-        if (3 * m_hashTable.size() != values.size()) {
+        m_encoded.reset();
+        const uint8_t* wire = ibltName.value();
+        const uint8_t* end = wire + ibltName.value_size();
+        if (wire == end) {
             BOOST_THROW_EXCEPTION(Error("Received IBF cannot be decoded!"));
         }
-        for (size_t i = 0; i < m_hashTable.size(); i++) {
-            HashTableEntry& entry = m_hashTable.at(i);
-            if (values[i * 3] != 0) {
-                entry.count = values[i * 3];
-                entry.keySum = values[(i * 3) + 1];
-                entry.keyCheck = values[(i * 3) + 2];
+        // a bare zlib stream (its first byte is always 0x78 with the default
+        // window size) is the encoding used before the format byte was added.
+        auto c = Compression::zlib;
+        bool sparse = false;
+        if (*wire != 0x78) {
+            c = Compression(*wire & ~SPARSE);
+            sparse = (*wire++ & SPARSE) != 0;
+            uint32_t cells;
+            if (! (wire = getVarint(wire, end, cells)) || cells == 0 ||
+                cells % N_HASH != 0 || cells > MAX_CELLS) {
+                BOOST_THROW_EXCEPTION(Error("Received IBF cannot be decoded!"));
             }
+            resize(cells);
+        }
+        // dense tables have a known size. Sparse ones carry their size
+        // when compressed.
+        uint32_t rawLen = size() * CELL_SIZE;
+        if (sparse) {
+            if (c == Compression::none) {
+                rawLen = end - wire;
+            } else if (! (wire = getVarint(wire, end, rawLen)) ||
+                       rawLen > size() * MAX_SPARSE_CELL) {
+                BOOST_THROW_EXCEPTION(Error("Received IBF cannot be decoded!"));
+            }
+        }
+        const uint8_t* raw = wire;
+        try {
+            if (c != Compression::none) {
+                auto& buf = codecScratch(rawLen);
+                decompressBlock(c, wire, end - wire, buf.data(), rawLen);
+                raw = buf.data();
+            } else if (size_t(end - wire) != rawLen) {
+                BOOST_THROW_EXCEPTION(Error("Received IBF cannot be decoded!"));
+            }
+        } catch (const CodecError& e) {
+            BOOST_THROW_EXCEPTION(Error(std::string("Received IBF cannot be decoded! ") + e.what()));
+        }
+        if (sparse) {
+            readSparse(raw, raw + rawLen);
+        } else {
+            readDense(raw);
         }
     }
 
+    /**
+     * @brief Set the compression used by encode()
+     *
+     * @throws Error if the compression wasn't compiled in
+     */
+    IBLT& setCompression(Compression c)
+    {
+        if (! isSupported(c)) {
+            BOOST_THROW_EXCEPTION(Error(std::string("IBF compression not supported: ")
+                                        + toString(c)));
+        }
+        if (c != m_compression) {
+            m_compression = c;
+            m_encoded.reset();
+        }
+        return *this;
+    }
+
+    Compression getCompression() const noexcept { return m_compression; }
+
     /**
      * Entry Hash functions. The hash table is split into N_HASH
      * equal-sized sub-tables with a different hash function for each.
@@ -231,17 +350,17 @@ class IBLT
      */
     auto hash0(size_t key) const noexcept
     {
-        auto stsize = m_hashTable.size() / N_HASH;
+        auto stsize = size() / N_HASH;
         return murmurHash3(0, key) % stsize;
     }
     auto hash1(size_t key) const noexcept
     {
-        auto stsize = m_hashTable.size() / N_HASH;
+        auto stsize = size() / N_HASH;
         return murmurHash3(1, key) % stsize + stsize;
     }
     auto hash2(size_t key) const noexcept
     {
-        auto stsize = m_hashTable.size() / N_HASH;
+        auto stsize = size() / N_HASH;
         return murmurHash3(2, key) % stsize + stsize * 2;
     }
 
@@ -256,7 +375,7 @@ class IBLT
      */
     bool chkPeer(size_t key, size_t idx) const noexcept
     {
-        auto hte = getHashTable().at(idx);
+        const auto hte = at(idx);
         return hte.isEmpty() || (hte.isPure() && hte.keySum != key);
     }
 
@@ -289,180 +408,320 @@ class IBLT
      * @param negative
      * @return true if decoding is complete successfully
      */
-    bool listEntries(std::set<uint32_t>& positive,
-                     std::set<uint32_t>& negative) const
+    bool listEntries(std::vector<uint32_t>& positive,
+                     std::vector<uint32_t>& negative) const
     {
         IBLT peeled = *this;
+        return peeled.peel(positive, negative);
+    }
 
-        bool peeledSomething;
-        do {
-            peeledSomething = false;
-            for (const auto& entry : peeled.m_hashTable) {
-                if (entry.isPure()) {
-                    if (peeled.badPeers(entry.keySum)) {
-                        std::cerr << "error - invalid iblt: badPeers for entry:"
-                            << entry << "\n";
-                        return false;
-                    }
-                    if (entry.count == 1) {
-                        positive.insert(entry.keySum);
-                    } else {
-                        negative.insert(entry.keySum);
-                    }
-                    peeled.update(-entry.count, entry.keySum);
-                    peeledSomething = true;
+    /**
+     * @brief listEntries() that peels this IBLT in place
+     *
+     * Cells are only revisited when a peel touches them so the cost is
+     * proportional to the table size plus the number of entries found
+     * rather than to the table size times the number of peel rounds.
+     * The entries found are appended to positive & negative then each
+     * vector is sorted. If decoding is incomplete the entries that could
+     * be peeled are still returned.
+     *
+     * @return true if every cell was peeled
+     */
+    bool peel(std::vector<uint32_t>& positive, std::vector<uint32_t>& negative)
+    {
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < size(); i++) {
+            if (cell(i).isPure()) {
+                pending.push_back(i);
+            }
+        }
+        bool ok = true;
+        while (! pending.empty()) {
+            const auto entry = cell(pending.back());
+            pending.pop_back();
+            if (! entry.isPure()) {
+                // already peeled via one of its peers
+                continue;
+            }
+            if (badPeers(entry.keySum)) {
+                std::cerr << "error - invalid iblt: badPeers for entry:"
+                    << entry << "\n";
+                ok = false;
+                break;
+            }
+            (entry.count == 1? positive : negative).push_back(entry.keySum);
+            for (auto idx : update(-entry.count, entry.keySum)) {
+                if (cell(idx).isPure()) {
+                    pending.push_back(idx);
                 }
             }
-        } while (peeledSomething);
-
+        }
+        std::sort(positive.begin(), positive.end());
+        std::sort(negative.begin(), negative.end());
+        if (! ok) {
+            return false;
+        }
+        for (size_t i = 0; i < size(); i++) {
+            if (! cell(i).isEmpty()) {
+                return false;
+            }
+        }
         return true;
     }
 
     IBLT operator-(const IBLT& other) const
     {
-        BOOST_ASSERT(m_hashTable.size() == other.m_hashTable.size());
+        IBLT result(0);
+        result.setDifference(*this, other);
+        return result;
+    }
+
+    /**
+     * @brief set this IBLT to a - b
+     *
+     * Reuses this IBLT's storage so a scratch table can be used for
+     * repeated differences without allocating.
+     */
+    void setDifference(const IBLT& a, const IBLT& b)
+    {
+        BOOST_ASSERT(a.size() == b.size());
+
+        const auto n = a.size();
+        resize(n);
+        m_encoded.reset();
+        const auto& k = simd::kernels();
+        k.sub32(m_count.data(), a.m_count.data(), b.m_count.data(), n);
+        k.xor32(m_keySum.data(), a.m_keySum.data(), b.m_keySum.data(), n);
+        k.xor32(m_keyCheck.data(), a.m_keyCheck.data(), b.m_keyCheck.data(), n);
+    }
 
-        IBLT result(*this);
-        for (size_t i = 0; i < m_hashTable.size(); i++) {
-            HashTableEntry& e1 = result.m_hashTable.at(i);
-            const HashTableEntry& e2 = other.m_hashTable.at(i);
-            e1.count -= e2.count;
-            e1.keySum ^= e2.keySum;
-            e1.keyCheck ^= e2.keyCheck;
+    bool operator==(const IBLT& other) const
+    {
+        const auto n = size();
+        if (n != other.size()) {
+            return false;
         }
-        return result;
+        const auto& k = simd::kernels();
+        return k.equal32((const uint32_t*)m_count.data(),
+                         (const uint32_t*)other.m_count.data(), n) &&
+               k.equal32(m_keySum.data(), other.m_keySum.data(), n) &&
+               k.equal32(m_keyCheck.data(), other.m_keyCheck.data(), n);
     }
 
-    std::vector<HashTableEntry> getHashTable() const { return m_hashTable; }
+    size_t size() const noexcept { return m_count.size(); }
+
+    /**
+     * @brief the cell at 'idx' (bounds checked)
+     */
+    HashTableEntry at(size_t idx) const
+    {
+        return {m_count.at(idx), m_keySum.at(idx), m_keyCheck.at(idx)};
+    }
+
+    /**
+     * @brief a copy of the table as an array of cells (for debugging)
+     */
+    std::vector<HashTableEntry> getHashTable() const
+    {
+        std::vector<HashTableEntry> table(size());
+        for (size_t i = 0; i < size(); i++) {
+            table[i] = cell(i);
+        }
+        return table;
+    }
 
     /**
      * @brief Appends self to name
      *
-     * Encodes our hash table from uint32_t vector to uint8_t vector
-     * We create a uin8_t vector 12 times the size of uint32_t vector
-     * We put the first count in first 4 cells, keySum in next 4, and keyCheck
-     * in next 4. Repeat for all the other cells of the hash table. Then we
-     * append this uint8_t vector to the name.
+     * Uses the cached encoding when the table hasn't changed since
+     * it was last encoded.
      *
      * @param name
      */
     void appendToName(ndn::Name& name) const
     {
-        size_t n = m_hashTable.size();
-        size_t unitSize = (32 * 3) / 8;  // hard coding
-        size_t tableSize = unitSize * n;
-
-        std::vector<char> table(tableSize);
-
-        for (size_t i = 0; i < n; i++) {
-            // table[i*12],   table[i*12+1], table[i*12+2], table[i*12+3] -->
-            // hashTable[i].count
-
-            table[(i * unitSize)] = 0xFF & m_hashTable[i].count;
-            table[(i * unitSize) + 1] = 0xFF & (m_hashTable[i].count >> 8);
-            table[(i * unitSize) + 2] = 0xFF & (m_hashTable[i].count >> 16);
-            table[(i * unitSize) + 3] = 0xFF & (m_hashTable[i].count >> 24);
-
-            // table[i*12+4], table[i*12+5], table[i*12+6], table[i*12+7] -->
-            // hashTable[i].keySum
-
-            table[(i * unitSize) + 4] = 0xFF & m_hashTable[i].keySum;
-            table[(i * unitSize) + 5] = 0xFF & (m_hashTable[i].keySum >> 8);
-            table[(i * unitSize) + 6] = 0xFF & (m_hashTable[i].keySum >> 16);
-            table[(i * unitSize) + 7] = 0xFF & (m_hashTable[i].keySum >> 24);
+        name.append(encode());
+    }
 
-            // table[i*12+8], table[i*12+9], table[i*12+10], table[i*12+11] -->
-            // hashTable[i].keyCheck
+    /**
+     * @brief true if the cached encoding matches the current table
+     */
+    bool isEncoded() const noexcept { return m_encoded.has_value(); }
 
-            table[(i * unitSize) + 8] = 0xFF & m_hashTable[i].keyCheck;
-            table[(i * unitSize) + 9] = 0xFF & (m_hashTable[i].keyCheck >> 8);
-            table[(i * unitSize) + 10] = 0xFF & (m_hashTable[i].keyCheck >> 16);
-            table[(i * unitSize) + 11] = 0xFF & (m_hashTable[i].keyCheck >> 24);
+    /**
+     * @brief Return the name component encoding of this IBLT
+     *
+     * The encoding is cached and only rebuilt after the table is modified
+     * (insert, erase or initialize).
+     */
+    const ndn::name::Component& encode() const
+    {
+        if (! m_encoded) {
+            m_encoded = makeComponent();
         }
-        bio::filtering_streambuf<bio::input> in;
-        in.push(bio::zlib_compressor());
-        in.push(bio::array_source(table.data(), table.size()));
-
-        std::stringstream sstream;
-        bio::copy(in, sstream);
-
-        std::string compressedIBF = sstream.str();
-        name.append((const uint8_t *)compressedIBF.data(), compressedIBF.size());
+        return *m_encoded;
     }
 
     /**
-     * @brief Extracts IBLT from name component
+     * @brief Encode self as a name component
+     *
+     * The component value is a one byte format code, the number of cells
+     * in the table as a varint, then the (compressed) table. The low bits
+     * of the format code are the Compression used; the SPARSE bit says the
+     * table is in the sparse layout. Whichever layout is smaller is used:
      *
-     * Converts the name into a uint8_t vector which is then decoded to a
-     * a uint32_t vector.
+     *  - dense: 12 bytes per cell: count, keySum and keyCheck, each a
+     *    little-endian uint32.
+     *  - sparse: only the non-empty cells, each as a varint index delta
+     *    (from the previous non-empty cell), a zigzag varint count, then
+     *    keySum and keyCheck as little-endian uint32. When compressed,
+     *    the uncompressed length precedes the data as a varint.
      *
-     * @param ibltName IBLT represented as a Name Component
-     * @return a uint32_t vector representing the hash table of the IBLT
+     * Cells are serialized into a reused buffer and compressed straight
+     * into a second one so the only copy is into the component itself.
      */
-    std::vector<uint32_t> extractValueFromName(
-        const ndn::name::Component& ibltName) const
+    ndn::name::Component makeComponent() const
     {
-        std::string compressed(ibltName.value_begin(), ibltName.value_end());
+        size_t nonEmpty = 0;
+        for (size_t i = 0; i < size(); i++) {
+            nonEmpty += ! cell(i).isEmpty();
+        }
+        const size_t denseLen = size() * CELL_SIZE;
+        const size_t rawMax = std::max(denseLen, nonEmpty * MAX_SPARSE_CELL);
+        const size_t maxLen = 1 + 2 * MAX_VARINT32 +
+                              maxCompressedSize(m_compression, rawMax);
+        auto& buf = codecScratch(maxLen + rawMax);
+        uint8_t* out = buf.data();
+        uint8_t* hdrEnd = putVarint(out + 1, size());
+        // uncompressed cells go straight after the header
+        uint8_t* raw = m_compression == Compression::none? hdrEnd : out + maxLen;
+
+        // most cells are empty in steady state. The sparse layout is written
+        // first when it could win and replaced by the dense one if it didn't.
+        uint8_t format = uint8_t(m_compression);
+        size_t rawLen = denseLen;
+        if (nonEmpty * MIN_SPARSE_CELL < denseLen &&
+            (rawLen = writeSparse(raw)) < denseLen) {
+            format |= SPARSE;
+        } else {
+            rawLen = writeDense(raw);
+        }
+        out[0] = format;
+        size_t len = (hdrEnd - out) + rawLen;
+        if (m_compression != Compression::none) {
+            uint8_t* p = hdrEnd;
+            if (format & SPARSE) {
+                p = putVarint(p, rawLen);
+            }
+            len = p - out;
+            len += compressBlock(m_compression, raw, rawLen, p, maxLen - len);
+        }
+        return ndn::name::Component(out, len);
+    }
 
-        bio::filtering_streambuf<bio::input> in;
-        in.push(bio::zlib_decompressor());
-        in.push(bio::array_source(compressed.data(), compressed.size()));
+   private:
+    void resize(size_t n)
+    {
+        m_count.resize(n);
+        m_keySum.resize(n);
+        m_keyCheck.resize(n);
+    }
 
-        std::stringstream sstream;
-        bio::copy(in, sstream);
-        std::string ibltStr = sstream.str();
+    HashTableEntry cell(size_t idx) const noexcept
+    {
+        return {m_count[idx], m_keySum[idx], m_keyCheck[idx]};
+    }
 
-        std::vector<uint8_t> ibltValues(ibltStr.begin(), ibltStr.end());
-        size_t n = ibltValues.size() / 4;
+    size_t writeDense(uint8_t* raw) const noexcept
+    {
+        for (size_t i = 0; i < size(); i++) {
+            putLE32(raw, m_count[i]);
+            putLE32(raw + 4, m_keySum[i]);
+            putLE32(raw + 8, m_keyCheck[i]);
+            raw += CELL_SIZE;
+        }
+        return size() * CELL_SIZE;
+    }
 
-        std::vector<uint32_t> values(n, 0);
+    void readDense(const uint8_t* raw) noexcept
+    {
+        for (size_t i = 0; i < size(); i++) {
+            m_count[i] = getLE32(raw);
+            m_keySum[i] = getLE32(raw + 4);
+            m_keyCheck[i] = getLE32(raw + 8);
+            raw += CELL_SIZE;
+        }
+    }
 
-        for (size_t i = 0; i < 4 * n; i += 4) {
-            uint32_t t = (ibltValues[i + 3] << 24) + (ibltValues[i + 2] << 16) +
-                         (ibltValues[i + 1] << 8) + ibltValues[i];
-            values[i / 4] = t;
+    size_t writeSparse(uint8_t* raw) const noexcept
+    {
+        uint8_t* p = raw;
+        size_t prev = 0;
+        for (size_t i = 0; i < size(); i++) {
+            if (cell(i).isEmpty()) {
+                continue;
+            }
+            p = putVarint(p, i - prev);
+            p = putVarint(p, zigzag(m_count[i]));
+            putLE32(p, m_keySum[i]);
+            putLE32(p + 4, m_keyCheck[i]);
+            p += 8;
+            prev = i;
         }
-        return values;
+        return p - raw;
     }
 
-   private:
-    void update(int plusOrMinus, uint32_t key)
+    void readSparse(const uint8_t* p, const uint8_t* end)
+    {
+        std::fill(m_count.begin(), m_count.end(), 0);
+        std::fill(m_keySum.begin(), m_keySum.end(), 0);
+        std::fill(m_keyCheck.begin(), m_keyCheck.end(), 0);
+        size_t idx = 0;
+        bool first = true;
+        while (p < end) {
+            uint32_t delta, count;
+            if (! (p = getVarint(p, end, delta)) || (delta == 0 && ! first) ||
+                (idx += delta) >= size() ||
+                ! (p = getVarint(p, end, count)) || end - p < 8) {
+                BOOST_THROW_EXCEPTION(Error("Received IBF cannot be decoded!"));
+            }
+            m_count[idx] = unzigzag(count);
+            m_keySum[idx] = getLE32(p);
+            m_keyCheck[idx] = getLE32(p + 4);
+            p += 8;
+            first = false;
+        }
+    }
+
+    /**
+     * Add or remove 'key' and return the indices of the cells it touched.
+     */
+    std::array<size_t, N_HASH> update(int plusOrMinus, uint32_t key)
     {
-        size_t bucketsPerHash = m_hashTable.size() / N_HASH;
+        std::array<size_t, N_HASH> touched;
+        m_encoded.reset();
+        size_t bucketsPerHash = size() / N_HASH;
+        uint32_t check = murmurHash3(N_HASHCHECK, key);
 
         for (size_t i = 0; i < N_HASH; i++) {
             size_t startEntry = i * bucketsPerHash;
             uint32_t h = murmurHash3(i, key);
-            HashTableEntry& entry =
-                m_hashTable.at(startEntry + (h % bucketsPerHash));
-            entry.count += plusOrMinus;
-            entry.keySum ^= key;
-            entry.keyCheck ^= murmurHash3(N_HASHCHECK, key);
+            auto idx = touched[i] = startEntry + (h % bucketsPerHash);
+            m_count.at(idx) += plusOrMinus;
+            m_keySum[idx] ^= key;
+            m_keyCheck[idx] ^= check;
         }
+        return touched;
     }
 
-    std::vector<HashTableEntry> m_hashTable;
+    // the cells, as a structure of arrays
+    std::vector<int32_t> m_count;
+    std::vector<uint32_t> m_keySum;
+    std::vector<uint32_t> m_keyCheck;
+    Compression m_compression{Compression::zlib};
+    mutable std::optional<ndn::name::Component> m_encoded;  // cached encode()
 };
 
-static inline bool operator==(const IBLT& iblt1, const IBLT& iblt2)
-{
-    auto iblt1HashTable = iblt1.getHashTable();
-    auto iblt2HashTable = iblt2.getHashTable();
-    if (iblt1HashTable.size() != iblt2HashTable.size()) {
-        return false;
-    }
-
-    size_t N = iblt1HashTable.size();
-
-    for (size_t i = 0; i < N; i++) {
-        if (iblt1HashTable[i].count != iblt2HashTable[i].count ||
-            iblt1HashTable[i].keySum != iblt2HashTable[i].keySum ||
-            iblt1HashTable[i].keyCheck != iblt2HashTable[i].keyCheck)
-            return false;
-    }
-    return true;
-}
-
 static inline bool operator!=(const IBLT& iblt1, const IBLT& iblt2)
 {
     return !(iblt1 == iblt2);
@@ -482,10 +741,10 @@ static inline std::string prtPeer(const IBLT& iblt, size_t idx, size_t rep)
     }
     std::ostringstream rslt{};
     rslt << " @" << std::hex << rep;
-    auto hte = iblt.getHashTable().at(rep);
+    const auto hte = iblt.at(rep);
     if (hte.isEmpty()) {
         rslt << "!";
-    } else if (iblt.getHashTable().at(idx).keySum != hte.keySum) {
+    } else if (iblt.at(idx).keySum != hte.keySum) {
         rslt << (hte.isPure()? "?" : "*");
     }
     return rslt.str();
@@ -493,7 +752,7 @@ static inline std::string prtPeer(const IBLT& iblt, size_t idx, size_t rep)
 
 static inline std::string prtPeers(const IBLT& iblt, size_t idx)
 {
-    auto hte = iblt.getHashTable().at(idx);
+    const auto hte = iblt.at(idx);
     if (! hte.isPure()) {
         // can only get the peers of 'pure' entries
         return "";
@@ -506,10 +765,8 @@ static inline std::string prtPeers(const IBLT& iblt, size_t idx)
 static inline std::ostream& operator<<(std::ostream& out, const IBLT& iblt)
 {
     out << "idx count keySum keyCheck\n";
-    auto idx = 0;
-    for (const auto& hte : iblt.getHashTable()) {
-        out << std::hex << std::setw(2) << idx << hte << prtPeers(iblt, idx) << "\n";
-        idx++;
+    for (size_t idx = 0; idx < iblt.size(); idx++) {
+        out << std::hex << std::setw(2) << idx << iblt.at(idx) << prtPeers(iblt, idx) << "\n";
     }
     return out;
 }
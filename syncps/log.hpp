@@ -1,7 +1,559 @@
+#ifndef EVAL_LOG_HPP
+#define EVAL_LOG_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <boost/log/attributes/value_extraction.hpp>
+#include <boost/log/core.hpp>
+#include <boost/log/sinks/basic_sink_backend.hpp>
+#include <boost/log/sinks/unlocked_frontend.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/log/utility/setup/common_attributes.hpp>
+#include <boost/log/utility/setup/file.hpp>
+#include <boost/make_shared.hpp>
+
 namespace logging = boost::log;
 namespace keywords = boost::log::keywords;
 
+/*
+ * Binary event log.
+ *
+ * Each thread that logs gets a lock-free ring of fixed size records that
+ * a background thread drains to the log file so logging an event is a
+ * few stores rather than formatting and flushing a line of text. The
+ * file starts with a Header that anchors the monotonic timestamps of
+ * the records to the wall clock. tools/evlog-decode turns a file back
+ * into the CSV written by the text log.
+ *
+ * Events are stamped with steady clock ns. That clock is shared by
+ * the processes on a host (and so by mininet's emulated nodes) so
+ * times logged by different nodes can be compared directly.
+ *
+ * Node names are logged as a 64 bit hash. The first time a thread logs
+ * a name it writes a NODE record defining the hash. Anything else
+ * logged through Boost.Log is written as TEXT. The text of NODE and
+ * TEXT records (at most maxText bytes) follows them in 'len' bytes
+ * rounded up to whole records.
+ */
+namespace evlog {
+
+enum Type : uint16_t {
+	TEXT = 1,
+	PUBL_MSG = 2,       // PUBL_MSG::<node>::<node>=<seq>::<ns>
+	RECV_STATE = 3,     // RECV_STATE::<node>::<seq>::<ns>[::<latency ns>]
+	NODE = 4,           // defines the name hashing to 'node'
+	THREAD = 5,         // 'seq' is the native id of thread 'thread'
+};
+
+struct Record {
+	uint64_t ns;        // steady clock
+	uint64_t node;
+	uint64_t seq;
+	uint32_t thread;    // index of the thread that logged it
+	uint16_t type;
+	uint16_t len;       // bytes of text that follow (RECV_STATE: 8 if the
+	                    // publication's ns follows)
+};
+static_assert(sizeof(Record) == 32, "evlog::Record must be 32 bytes");
+
+struct Header {
+	char magic[8];      // "EVLOG01\n"
+	uint64_t wallNs;    // system clock (ns since the epoch) at steadyNs
+	uint64_t steadyNs;
+	int32_t utcOffset;  // local time - UTC in seconds
+	uint32_t pid;
+};
+constexpr char magic[8] = {'E', 'V', 'L', 'O', 'G', '0', '1', '\n'};
+constexpr size_t maxText = 4096;
+
+inline uint64_t
+steadyNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t
+wallNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+inline uint64_t
+hashName(const std::string& s)
+{
+	// FNV-1a
+	uint64_t h = 14695981039346656037ull;
+	for (unsigned char c : s) {
+		h = (h ^ c) * 1099511628211ull;
+	}
+	return h;
+}
+
+template <typename N>
+std::string
+toString(const N& v)
+{
+	std::ostringstream ss;
+	ss << v;
+	return ss.str();
+}
+
+inline const std::string& toString(const std::string& s) { return s; }
+
+/*
+ * The text log's message for an event at 'ns'. 'pubNs' is when a
+ * received publication was published (if known).
+ */
+inline std::string
+format(Type type, const std::string& node, uint64_t seq, uint64_t ns, uint64_t pubNs = 0)
+{
+	std::ostringstream ss;
+	if (type == PUBL_MSG) {
+		ss << "PUBL_MSG::" << node << "::" << node << "=" << seq << "::" << ns;
+	} else {
+		ss << "RECV_STATE::" << node << "::" << seq << "::" << ns;
+		if (pubNs != 0) {
+			ss << "::" << int64_t(ns - pubNs);
+		}
+	}
+	return ss.str();
+}
+
+// the text log's line for the wall clock anchor of a run
+inline std::string
+anchor(uint64_t wall, uint64_t steady)
+{
+	return "RUN_ANCHOR::" + std::to_string(wall) + "::" + std::to_string(steady);
+}
+
+/*
+ * One thread's records. Only that thread pushes and only the log's
+ * thread pops.
+ */
+class Ring {
+public:
+	static constexpr size_t N = 1 << 16;
+
+	explicit Ring(uint32_t thread) : m_thread(thread), m_buf(N) { }
+
+	uint32_t thread() const { return m_thread; }
+
+	// push 'n' records as a unit (waiting for room if need be)
+	void
+	push(const Record* r, size_t n)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		while (tail + n - m_head.load(std::memory_order_acquire) > N) {
+			std::this_thread::yield();
+		}
+		for (size_t i = 0; i < n; i++) {
+			m_buf[(tail + i) & (N - 1)] = r[i];
+		}
+		m_tail.store(tail + n, std::memory_order_release);
+	}
+
+	// append the available records to 'out'
+	size_t
+	drain(std::vector<Record>& out)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		size_t tail = m_tail.load(std::memory_order_acquire);
+		for (size_t i = head; i != tail; i++) {
+			out.push_back(m_buf[i & (N - 1)]);
+		}
+		m_head.store(tail, std::memory_order_release);
+		return tail - head;
+	}
+
+private:
+	uint32_t m_thread;
+	std::vector<Record> m_buf;
+	alignas(64) std::atomic<size_t> m_head{0};
+	alignas(64) std::atomic<size_t> m_tail{0};
+};
+
+class Log {
+public:
+	static Log&
+	get()
+	{
+		static Log log;
+		return log;
+	}
+
+	~Log() { close(); }
+
+	bool active() const { return m_file != nullptr; }
+
+	bool
+	open(const std::string& filename)
+	{
+		m_file = std::fopen(filename.c_str(), "ab");
+		if (m_file == nullptr) {
+			return false;
+		}
+		Header h{};
+		std::memcpy(h.magic, magic, sizeof(h.magic));
+		h.steadyNs = steadyNs();
+		h.wallNs = wallNs();
+		std::time_t t = h.wallNs / 1000000000;
+		std::tm local;
+		localtime_r(&t, &local);
+		h.utcOffset = local.tm_gmtoff;
+		h.pid = getpid();
+		std::fwrite(&h, sizeof(h), 1, m_file);
+		m_thread = std::thread([this] { run(); });
+		return true;
+	}
+
+	// write out what's been logged and close the file
+	void
+	close()
+	{
+		if (m_thread.joinable()) {
+			m_stop = true;
+			m_thread.join();
+		}
+		if (m_file != nullptr) {
+			std::fclose(m_file);
+			m_file = nullptr;
+		}
+	}
+
+	template <typename N>
+	void
+	event(Type type, const N& node, uint64_t seq, uint64_t pubNs = 0)
+	{
+		auto& r = ring();
+		const auto& name = toString(node);
+		uint64_t h = hashName(name);
+		thread_local std::unordered_set<uint64_t> defined;
+		if (defined.insert(h).second) {
+			text(r, NODE, h, name);
+		}
+		Record e[2] = {{steadyNs(), h, seq, r.thread(), type, 0}, {}};
+		if (pubNs != 0) {
+			e[0].len = sizeof(pubNs);
+			e[1].ns = pubNs;
+		}
+		r.push(e, pubNs != 0 ? 2 : 1);
+	}
+
+	void
+	text(const std::string& s)
+	{
+		text(ring(), TEXT, 0, s);
+	}
+
+private:
+	void
+	text(Ring& r, Type type, uint64_t node, const std::string& s)
+	{
+		size_t len = std::min(s.size(), maxText);
+		Record buf[1 + maxText / sizeof(Record)];
+		buf[0] = Record{steadyNs(), node, 0, r.thread(), type, uint16_t(len)};
+		size_t n = (len + sizeof(Record) - 1) / sizeof(Record);
+		std::memset(&buf[1], 0, n * sizeof(Record));
+		std::memcpy(&buf[1], s.data(), len);
+		r.push(buf, 1 + n);
+	}
+
+	// the calling thread's ring (made the first time it logs)
+	Ring&
+	ring()
+	{
+		thread_local Ring* r = nullptr;
+		if (r == nullptr) {
+			std::lock_guard<std::mutex> lock(m_ringsMutex);
+			m_rings.push_back(std::make_unique<Ring>(m_rings.size()));
+			r = m_rings.back().get();
+			Record t{steadyNs(), 0, uint64_t(pthread_self()), r->thread(), THREAD, 0};
+			r->push(&t, 1);
+		}
+		return *r;
+	}
+
+	void
+	run()
+	{
+		std::vector<Ring*> rings;
+		std::vector<Record> out;
+		while (true) {
+			bool stop = m_stop;
+			{
+				std::lock_guard<std::mutex> lock(m_ringsMutex);
+				rings.clear();
+				for (auto& r : m_rings) {
+					rings.push_back(r.get());
+				}
+			}
+			out.clear();
+			for (auto r : rings) {
+				r->drain(out);
+			}
+			if (!out.empty()) {
+				std::fwrite(out.data(), sizeof(Record), out.size(), m_file);
+				std::fflush(m_file);
+			}
+			if (stop) {
+				return;
+			}
+			if (out.empty()) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+	}
+
+	std::FILE* m_file = nullptr;
+	std::thread m_thread;
+	std::atomic<bool> m_stop{false};
+	std::mutex m_ringsMutex;    // only taken when a thread first logs
+	std::vector<std::unique_ptr<Ring>> m_rings;
+};
+
+// Boost.Log sink that writes messages to the binary log as TEXT
+class Backend : public logging::sinks::basic_sink_backend<logging::sinks::concurrent_feeding> {
+public:
+	void
+	consume(const logging::record_view& rec)
+	{
+		if (auto msg = logging::extract<std::string>("Message", rec)) {
+			Log::get().text(*msg);
+		}
+	}
+};
+
+} // namespace evlog
+
+/*
+ * Log an event to the binary log if there is one, otherwise to the
+ * text log. 'pubNs' is when a received publication was published, if
+ * it carries that.
+ */
+template <typename N>
+void
+logEvent(evlog::Type type, const N& node, uint64_t seq, uint64_t pubNs = 0)
+{
+	if (evlog::Log::get().active()) {
+		evlog::Log::get().event(type, node, seq, pubNs);
+	} else {
+		BOOST_LOG_TRIVIAL(info) << evlog::format(type, evlog::toString(node), seq,
+		                                         evlog::steadyNs(), pubNs);
+	}
+}
+
+/*
+ * The sync prefix: /ndn/svs, or EVAL_SYNC_PREFIX if set (svs.py gives
+ * experiments that run at the same time their own /ndn/svs/<slot>).
+ */
+inline std::string syncPrefix() {
+	const char* prefix = getenv("EVAL_SYNC_PREFIX");
+	return prefix != nullptr && *prefix != '\0' ? prefix : "/ndn/svs";
+}
+
+/*
+ * The windows of a run, in seconds from its first publication, which
+ * svs.py sets through the environment:
+ *
+ *   EVAL_WARMUP   publishing, not measured (default 0)
+ *   EVAL_MEASURE  publishing, measured (default 120)
+ *   EVAL_DRAIN    no more publishing, the run ends after it (default 30)
+ *
+ * PHASE::<phase>::<ns> is logged as each one starts so the analysis can
+ * tell events apart by phase. With EVAL_NODES (the number of nodes in
+ * the run) set the drain ends as soon as every node has converged: a
+ * node that stops publishing writes its count of publications to
+ * <logfile>.final, and one that has the finals of EVAL_NODES nodes and
+ * received that many publications from the others writes
+ * <logfile>.converged. The nodes' logs share a directory (mininet's
+ * hosts share the file system) so each can see the others' files.
+ */
+class Phases {
+public:
+	enum Phase { WARMUP, MEASURE, DRAIN, DONE };
+
+	explicit Phases(const std::string& logfile)
+		: m_logfile(logfile)
+		, m_warmup(envInt("EVAL_WARMUP", 0))
+		, m_measure(envInt("EVAL_MEASURE", 120))
+		, m_drain(envInt("EVAL_DRAIN", 30))
+		, m_nodes(envInt("EVAL_NODES", 0))
+	{
+		auto slash = logfile.rfind('/');
+		m_dir = slash == std::string::npos ? "." : logfile.substr(0, slash);
+		m_base = slash == std::string::npos ? logfile : logfile.substr(slash + 1);
+	}
+
+	// whether the drain can end early, and is worth checking often
+	bool
+	earlyExit() const
+	{
+		return m_nodes > 0;
+	}
+
+	// the phase 'elapsed' into the run, logging it if it just started
+	Phase
+	at(std::chrono::steady_clock::duration elapsed)
+	{
+		Phase phase = DONE;
+		if (elapsed < std::chrono::seconds(m_warmup)) {
+			phase = WARMUP;
+		} else if (elapsed <= std::chrono::seconds(m_warmup + m_measure)) {
+			phase = MEASURE;
+		} else if (elapsed <= std::chrono::seconds(m_warmup + m_measure + m_drain)) {
+			phase = DRAIN;
+		}
+
+		if (phase >= DRAIN && !m_final) {
+			m_final = true;
+			writeFile(m_logfile + ".final", std::to_string(m_published));
+		}
+		if (phase == DRAIN && earlyExit() && converged()) {
+			phase = DONE;
+		}
+		if (phase != m_phase) {
+			static const char* names[] = {"WARMUP", "MEASURE", "DRAIN", "DONE"};
+			BOOST_LOG_TRIVIAL(info) << "PHASE::" << names[phase] << "::" << evlog::steadyNs();
+			m_phase = phase;
+		}
+		return phase;
+	}
+
+	void
+	published()
+	{
+		m_published++;
+	}
+
+	template <typename N>
+	void
+	received(const N& node, uint64_t seq)
+	{
+		if (earlyExit()) {
+			m_received.insert(evlog::toString(node) + "\n" + std::to_string(seq));
+		}
+	}
+
+private:
+	static int
+	envInt(const char* name, int def)
+	{
+		const char* value = getenv(name);
+		return value != nullptr && *value != '\0' ? atoi(value) : def;
+	}
+
+	static void
+	writeFile(const std::string& filename, const std::string& text)
+	{
+		// written under another name first so readers never see it partial
+		std::string tmp = filename + ".tmp";
+		if (std::FILE* f = std::fopen(tmp.c_str(), "w")) {
+			std::fputs(text.c_str(), f);
+			std::fclose(f);
+			std::rename(tmp.c_str(), filename.c_str());
+		}
+	}
+
+	// the contents of the files in m_dir ending in 'suffix' but for ours
+	std::vector<std::string>
+	othersFiles(const std::string& suffix, int* count) const
+	{
+		std::vector<std::string> contents;
+		*count = 0;
+		DIR* dir = opendir(m_dir.c_str());
+		if (dir == nullptr) {
+			return contents;
+		}
+		while (struct dirent* e = readdir(dir)) {
+			std::string name = e->d_name;
+			if (name.size() <= suffix.size() ||
+			    name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+				continue;
+			}
+			++*count;
+			if (name == m_base + suffix) {
+				continue;
+			}
+			std::string path = m_dir + "/" + name;
+			std::string text;
+			if (std::FILE* f = std::fopen(path.c_str(), "r")) {
+				char buf[64];
+				size_t n = std::fread(buf, 1, sizeof(buf), f);
+				text.assign(buf, n);
+				std::fclose(f);
+			}
+			contents.push_back(text);
+		}
+		closedir(dir);
+		return contents;
+	}
+
+	// whether all m_nodes nodes have converged (and so have we)
+	bool
+	converged()
+	{
+		int count;
+		if (!m_converged) {
+			uint64_t expected = 0;
+			for (const auto& text : othersFiles(".final", &count)) {
+				expected += strtoull(text.c_str(), NULL, 10);
+			}
+			if (count < m_nodes || m_received.size() < expected) {
+				return false;
+			}
+			m_converged = true;
+			writeFile(m_logfile + ".converged", "");
+		}
+		othersFiles(".converged", &count);
+		return count >= m_nodes;
+	}
+
+	std::string m_logfile;
+	std::string m_dir;
+	std::string m_base;         // m_logfile without m_dir
+	int m_warmup;
+	int m_measure;
+	int m_drain;
+	int m_nodes;
+	int m_phase = -1;
+	uint64_t m_published = 0;
+	bool m_final = false;
+	bool m_converged = false;
+	// <node>\n<seq> of the publications received
+	std::unordered_set<std::string> m_received;
+};
+
+/*
+ * A filename ending in ".bin" gets the binary event log, anything else
+ * the CSV text log.
+ */
 void initlogger(std::string filename) {
+	if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".bin") == 0 &&
+	    evlog::Log::get().open(filename)) {
+		logging::core::get()->add_sink(
+			boost::make_shared<logging::sinks::unlocked_sink<evlog::Backend>>());
+		return;
+	}
 	logging::add_common_attributes();
 	logging::add_file_log
 	(
@@ -10,5 +562,8 @@ void initlogger(std::string filename) {
 		keywords::open_mode = std::ios_base::app,
 		keywords::auto_flush = true
 	);
+	// (the binary log's header holds this)
+	BOOST_LOG_TRIVIAL(info) << evlog::anchor(evlog::wallNs(), evlog::steadyNs());
 }
 
+#endif // EVAL_LOG_HPP
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_NAME_TRIE_HPP
+#define SYNCPS_NAME_TRIE_HPP
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <ndn-cxx/name.hpp>
+
+namespace syncps {
+
+/**
+ * @brief Name component trie for longest prefix match
+ *
+ * Each edge is one name component, keyed by the component's wire
+ * encoding (so components of different types never match). A lookup
+ * does one hash probe per component of the name so it's O(name length)
+ * whatever the number of prefixes in the trie, and it doesn't allocate.
+ */
+template<typename V>
+class NameTrie
+{
+  public:
+    /**
+     * @brief result of a longest prefix match
+     */
+    struct Match
+    {
+        V* value;           // value of the longest matching prefix or nullptr
+        size_t length;      // number of components in that prefix
+    };
+
+    /**
+     * @brief set the value of 'prefix' (replacing any existing value)
+     */
+    void insert(const ndn::Name& prefix, V value)
+    {
+        Node* n = &m_root;
+        for (const auto& c : prefix) {
+            auto k = key(c);
+            auto kid = n->kids.find(k);
+            if (kid == n->kids.end()) {
+                auto node = std::make_unique<Node>();
+                node->comp.assign(k);
+                node->parent = n;
+                std::string_view nk(node->comp);
+                kid = n->kids.emplace(nk, std::move(node)).first;
+            }
+            n = kid->second.get();
+        }
+        m_size += ! n->value;
+        n->value = std::move(value);
+    }
+
+    /**
+     * @brief remove the value of 'prefix' (if any)
+     *
+     * @return true if 'prefix' had a value
+     */
+    bool erase(const ndn::Name& prefix)
+    {
+        Node* n = find(prefix);
+        if (n == nullptr || ! n->value) {
+            return false;
+        }
+        n->value.reset();
+        --m_size;
+        // prune nodes that no longer lead anywhere
+        while (n != &m_root && ! n->value && n->kids.empty()) {
+            Node* parent = n->parent;
+            parent->kids.erase(std::string_view(n->comp));
+            n = parent;
+        }
+        return true;
+    }
+
+    /**
+     * @brief value of the longest prefix of 'name' in the trie
+     */
+    Match longestPrefixMatch(const ndn::Name& name)
+    {
+        Match m{m_root.value? &*m_root.value : nullptr, 0};
+        const Node* n = &m_root;
+        size_t len = 0;
+        for (const auto& c : name) {
+            auto kid = n->kids.find(key(c));
+            if (kid == n->kids.end()) {
+                break;
+            }
+            n = kid->second.get();
+            ++len;
+            if (n->value) {
+                m = {const_cast<V*>(&*n->value), len};
+            }
+        }
+        return m;
+    }
+
+    size_t size() const noexcept { return m_size; }
+
+    bool empty() const noexcept { return m_size == 0; }
+
+  private:
+    struct Node
+    {
+        std::string comp{};     // wire encoding of the component leading here
+        Node* parent{};
+        std::optional<V> value{};
+        // keys are views of the kid's 'comp'
+        std::unordered_map<std::string_view, std::unique_ptr<Node>> kids{};
+    };
+
+    static std::string_view key(const ndn::name::Component& c)
+    {
+        return std::string_view(reinterpret_cast<const char*>(c.wire()), c.size());
+    }
+
+    Node* find(const ndn::Name& prefix)
+    {
+        Node* n = &m_root;
+        for (const auto& c : prefix) {
+            auto kid = n->kids.find(key(c));
+            if (kid == n->kids.end()) {
+                return nullptr;
+            }
+            n = kid->second.get();
+        }
+        return n;
+    }
+
+    Node m_root{};
+    size_t m_size{};
+};
+
+}  // namespace syncps
+
+#endif  // SYNCPS_NAME_TRIE_HPP
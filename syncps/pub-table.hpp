@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_PUB_TABLE_HPP
+#define SYNCPS_PUB_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace syncps {
+
+/**
+ * @brief Table of active publications keyed by their 32 bit hash
+ *
+ * Open addressing with linear probing. The hash, flags and publication
+ * of an entry are stored together in the slot so a lookup touches one
+ * cache line rather than walking map nodes. Erase shifts later entries
+ * of the probe run back so there are no tombstones.
+ *
+ * Pointers to entries are invalidated by insert and erase.
+ */
+template<typename PubPtr>
+class PubTable
+{
+  public:
+    struct Entry
+    {
+        PubPtr pub{};       // null if the slot is empty
+        uint32_t hash{};
+        uint8_t flags{};
+    };
+
+    size_t size() const noexcept { return m_size; }
+
+    bool empty() const noexcept { return m_size == 0; }
+
+    Entry* find(uint32_t hash) noexcept
+    {
+        if (m_slots.empty()) {
+            return nullptr;
+        }
+        for (size_t i = hash & m_mask; m_slots[i].pub; i = (i + 1) & m_mask) {
+            if (m_slots[i].hash == hash) {
+                return &m_slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const Entry* find(uint32_t hash) const noexcept
+    {
+        return const_cast<PubTable*>(this)->find(hash);
+    }
+
+    bool contains(uint32_t hash) const noexcept { return find(hash) != nullptr; }
+
+    /**
+     * @brief add a publication (replacing any with the same hash)
+     */
+    Entry& insert(uint32_t hash, PubPtr pub, uint8_t flags)
+    {
+        if ((m_size + 1) * 4 > m_slots.size() * 3) {
+            rehash(m_slots.empty()? 16 : m_slots.size() * 2);
+        }
+        size_t i = hash & m_mask;
+        for (; m_slots[i].pub; i = (i + 1) & m_mask) {
+            if (m_slots[i].hash == hash) {
+                break;
+            }
+        }
+        auto& e = m_slots[i];
+        m_size += ! e.pub;
+        e.pub = std::move(pub);
+        e.hash = hash;
+        e.flags = flags;
+        return e;
+    }
+
+    /**
+     * @return true if there was an entry for 'hash'
+     */
+    bool erase(uint32_t hash) noexcept
+    {
+        auto e = find(hash);
+        if (e == nullptr) {
+            return false;
+        }
+        // move back any later entries of the run that can fill the hole
+        size_t hole = e - m_slots.data();
+        for (size_t i = (hole + 1) & m_mask; m_slots[i].pub; i = (i + 1) & m_mask) {
+            size_t home = m_slots[i].hash & m_mask;
+            if (((i - home) & m_mask) >= ((i - hole) & m_mask)) {
+                m_slots[hole] = std::move(m_slots[i]);
+                hole = i;
+            }
+        }
+        m_slots[hole] = Entry{};
+        --m_size;
+        return true;
+    }
+
+    /**
+     * @brief call 'f(Entry&)' for each entry. 'f' must not insert or erase.
+     */
+    template<typename F>
+    void forEach(F&& f)
+    {
+        for (auto& e : m_slots) {
+            if (e.pub) {
+                f(e);
+            }
+        }
+    }
+
+    template<typename F>
+    void forEach(F&& f) const
+    {
+        for (const auto& e : m_slots) {
+            if (e.pub) {
+                f(e);
+            }
+        }
+    }
+
+  private:
+    void rehash(size_t n)
+    {
+        std::vector<Entry> old(n);
+        old.swap(m_slots);
+        m_mask = n - 1;
+        m_size = 0;
+        for (auto& e : old) {
+            if (e.pub) {
+                insert(e.hash, std::move(e.pub), e.flags);
+            }
+        }
+    }
+
+    std::vector<Entry> m_slots{};
+    size_t m_mask{};
+    size_t m_size{};
+};
+
+}  // namespace syncps
+
+#endif  // SYNCPS_PUB_TABLE_HPP
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_PUB_VERIFIER_HPP
+#define SYNCPS_PUB_VERIFIER_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/asio/io_service.hpp>
+
+#include <ndn-cxx/data.hpp>
+
+namespace syncps {
+
+/**
+ * @brief check of one publication (called on a worker thread)
+ *
+ * Must be safe to call concurrently from several threads.
+ */
+using VerifyPubCb = std::function<bool(const ndn::Data&)>;
+
+/**
+ * @brief Pool of threads that verify publications off the face thread
+ *
+ * submit() queues a publication for verification. The workers run the
+ * VerifyPubCb and the results are handed to the 'done' callback on the
+ * io_service's thread (the face thread) in the order the publications
+ * were submitted. Results that complete together are handed over as
+ * one batch.
+ *
+ * submit() and the destructor must be called on the face thread.
+ * Results not yet handed over when the pool is destroyed are dropped.
+ */
+class PubVerifier
+{
+  public:
+    struct Result
+    {
+        uint32_t hash;
+        std::shared_ptr<ndn::Data> pub;
+        bool ok;
+    };
+    using DoneCb = std::function<void(std::vector<Result>&)>;
+
+    PubVerifier(boost::asio::io_service& ios, VerifyPubCb verify, DoneCb done,
+                size_t nThreads)
+        : m_ios(ios), m_verify(std::move(verify)), m_state(std::make_shared<State>())
+    {
+        m_state->done = std::move(done);
+        for (size_t i = 0; i < std::max<size_t>(nThreads, 1); i++) {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~PubVerifier()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_work.notify_all();
+        for (auto& t : m_workers) {
+            t.join();
+        }
+    }
+
+    PubVerifier(const PubVerifier&) = delete;
+    PubVerifier& operator=(const PubVerifier&) = delete;
+
+    void submit(uint32_t hash, std::shared_ptr<ndn::Data> pub)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back({m_nextSeq++, hash, std::move(pub)});
+        }
+        m_work.notify_one();
+    }
+
+    /**
+     * @brief number of publications submitted but not yet handed back
+     */
+    size_t pending() const noexcept { return m_nextSeq - m_state->nextDone; }
+
+  private:
+    struct Job
+    {
+        uint64_t seq;
+        uint32_t hash;
+        std::shared_ptr<ndn::Data> pub;
+    };
+
+    // what the face thread handlers need. It's shared with them so a
+    // handler that runs after the pool is gone can tell.
+    struct State
+    {
+        std::mutex mutex;
+        std::map<uint64_t, Result> results{};  // completed, by seq
+        uint64_t nextDone{};                // seq of next result to hand back
+        bool drainPosted{false};
+        DoneCb done;
+    };
+
+    void work()
+    {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_work.wait(lock, [this] { return m_stop || ! m_jobs.empty(); });
+                if (m_stop) {
+                    return;
+                }
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+            bool ok = false;
+            try {
+                ok = m_verify(*job.pub);
+            } catch (const std::exception&) {
+                // a pub that can't be checked is treated as bad
+            }
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            m_state->results.emplace(job.seq, Result{job.hash, std::move(job.pub), ok});
+            if (job.seq == m_state->nextDone && ! m_state->drainPosted) {
+                m_state->drainPosted = true;
+                m_ios.post([s = std::weak_ptr<State>(m_state)] { drain(s); });
+            }
+        }
+    }
+
+    // hand back the results that are next in submission order
+    static void drain(const std::weak_ptr<State>& weak)
+    {
+        auto s = weak.lock();
+        if (! s) {
+            return;
+        }
+        std::vector<Result> batch;
+        {
+            std::lock_guard<std::mutex> lock(s->mutex);
+            s->drainPosted = false;
+            for (auto r = s->results.begin();
+                 r != s->results.end() && r->first == s->nextDone;
+                 r = s->results.erase(r), ++s->nextDone) {
+                batch.push_back(std::move(r->second));
+            }
+        }
+        if (! batch.empty()) {
+            s->done(batch);
+        }
+    }
+
+    boost::asio::io_service& m_ios;
+    VerifyPubCb m_verify;
+    std::shared_ptr<State> m_state;
+    std::mutex m_mutex;                 // protects m_jobs and m_stop
+    std::condition_variable m_work;
+    std::deque<Job> m_jobs{};
+    bool m_stop{false};
+    uint64_t m_nextSeq{};               // only used on the face thread
+    std::vector<std::thread> m_workers{};
+};
+
+}  // namespace syncps
+
+#endif  // SYNCPS_PUB_VERIFIER_HPP
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_SIGNER_HPP
+#define SYNCPS_SIGNER_HPP
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-info.hpp>
+#include <ndn-cxx/util/sha256.hpp>
+
+#include "codec.hpp"
+
+namespace syncps {
+
+using DataBatch = std::vector<std::shared_ptr<ndn::Data>>;
+
+/**
+ * @brief Backend that signs publications and sync Data
+ */
+class Signer
+{
+  public:
+    virtual ~Signer() = default;
+
+    virtual void sign(ndn::Data& data, const ndn::security::SigningInfo& info) = 0;
+
+    /**
+     * @brief sign Data that are sent together (e.g., the segments of a reply)
+     */
+    virtual void sign(const DataBatch& batch, const ndn::security::SigningInfo& info)
+    {
+        for (const auto& d : batch) {
+            sign(*d, info);
+        }
+    }
+};
+
+/**
+ * @brief Sign each Data with the KeyChain
+ */
+class KeyChainSigner : public Signer
+{
+  public:
+    explicit KeyChainSigner(ndn::KeyChain& keyChain) : m_keyChain(keyChain) { }
+
+    using Signer::sign;
+
+    void sign(ndn::Data& data, const ndn::security::SigningInfo& info) override
+    {
+        m_keyChain.sign(data, info);
+    }
+
+  protected:
+    ndn::KeyChain& m_keyChain;
+};
+
+/**
+ * @brief Sign a batch of Data with one signature over a Merkle tree
+ *
+ * The leaves of the tree are the SHA256 digests of the signed portion of
+ * each Data (which includes a SignatureInfo of type merkleSignatureType).
+ * Only the root is signed with the KeyChain. Each Data's SignatureValue
+ * holds the root's signature (a SignatureValue TLV), its leaf index and
+ * the batch size (little-endian uint32s) then the sibling digests on the
+ * path from its leaf to the root. A node without a sibling is carried up
+ * unchanged.
+ *
+ * This saves signatures when the signing key is expensive to use (the
+ * default SHA256 digest 'signing' is already cheap). Validators have to
+ * understand the signature type; see rootOf().
+ */
+class MerkleSigner : public KeyChainSigner
+{
+  public:
+    using Digest = std::array<uint8_t, 32>;
+    static constexpr uint32_t merkleSignatureType = 200;
+
+    using KeyChainSigner::KeyChainSigner;
+    using KeyChainSigner::sign;
+
+    void sign(const DataBatch& batch, const ndn::security::SigningInfo& info) override
+    {
+        if (batch.size() < 2) {
+            KeyChainSigner::sign(batch, info);
+            return;
+        }
+        ndn::SignatureInfo sigInfo(static_cast<ndn::tlv::SignatureTypeValue>(merkleSignatureType));
+        std::vector<ndn::EncodingBuffer> encoders(batch.size());
+        std::vector<std::vector<Digest>> levels(1);
+        for (size_t i = 0; i < batch.size(); i++) {
+            batch[i]->setSignature(ndn::Signature(sigInfo));
+            batch[i]->wireEncode(encoders[i], true);
+            levels[0].push_back(digest(encoders[i].buf(), encoders[i].size()));
+        }
+        while (levels.back().size() > 1) {
+            const auto& level = levels.back();
+            std::vector<Digest> up;
+            for (size_t j = 0; j < level.size(); j += 2) {
+                up.push_back(j + 1 < level.size()? parent(level[j], level[j + 1]) : level[j]);
+            }
+            levels.push_back(std::move(up));
+        }
+        const auto& root = levels.back().front();
+        auto rootSig = m_keyChain.sign(root.data(), root.size(), info);
+
+        std::vector<uint8_t> value;
+        for (size_t i = 0; i < batch.size(); i++) {
+            value.assign(rootSig.wire(), rootSig.wire() + rootSig.size());
+            value.resize(value.size() + 8);
+            putLE32(value.data() + value.size() - 8, i);
+            putLE32(value.data() + value.size() - 4, batch.size());
+            size_t idx = i;
+            for (size_t l = 0; l + 1 < levels.size(); l++, idx /= 2) {
+                if (auto sib = idx ^ 1; sib < levels[l].size()) {
+                    value.insert(value.end(), levels[l][sib].begin(), levels[l][sib].end());
+                }
+            }
+            batch[i]->wireEncode(encoders[i], ndn::makeBinaryBlock(ndn::tlv::SignatureValue,
+                                                                   value.data(), value.size()));
+        }
+    }
+
+    /**
+     * @brief Recompute the Merkle root that signs 'data'
+     *
+     * @return the root and the root's signature or nothing if 'data'
+     *         doesn't have a well-formed Merkle batch signature
+     */
+    static std::optional<std::pair<Digest, ndn::Block>> rootOf(const ndn::Data& data)
+    {
+        try {
+            auto sig = data.getSignature();
+            if (uint32_t(sig.getType()) != merkleSignatureType) {
+                return std::nullopt;
+            }
+            const auto& wire = data.wireEncode();
+            wire.parse();
+            const auto& nm = wire.get(ndn::tlv::Name);
+            const auto& si = wire.get(ndn::tlv::SignatureInfo);
+            auto d = digest(nm.wire(), si.wire() + si.size() - nm.wire());
+
+            const auto& sv = sig.getValue();
+            const uint8_t* p = sv.value();
+            const uint8_t* end = p + sv.value_size();
+            ndn::Block rootSig(p, end - p);
+            p += rootSig.size();
+            if (end - p < 8) {
+                return std::nullopt;
+            }
+            size_t idx = getLE32(p);
+            size_t n = getLE32(p + 4);
+            p += 8;
+            if (idx >= n) {
+                return std::nullopt;
+            }
+            for (; n > 1; idx /= 2, n = (n + 1) / 2) {
+                if ((idx ^ 1) >= n) {
+                    continue;
+                }
+                if (end - p < 32) {
+                    return std::nullopt;
+                }
+                Digest sib;
+                std::memcpy(sib.data(), p, sib.size());
+                p += sib.size();
+                d = (idx & 1)? parent(sib, d) : parent(d, sib);
+            }
+            if (p != end) {
+                return std::nullopt;
+            }
+            return std::make_pair(d, std::move(rootSig));
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+    }
+
+  private:
+    static Digest digest(const uint8_t* buf, size_t len)
+    {
+        Digest d;
+        auto h = ndn::util::Sha256::computeDigest(buf, len);
+        std::memcpy(d.data(), h->data(), d.size());
+        return d;
+    }
+
+    static Digest parent(const Digest& left, const Digest& right)
+    {
+        ndn::util::Sha256 h;
+        h.update(left.data(), left.size());
+        h.update(right.data(), right.size());
+        Digest d;
+        std::memcpy(d.data(), h.computeDigest()->data(), d.size());
+        return d;
+    }
+};
+
+}  // namespace syncps
+
+#endif  // SYNCPS_SIGNER_HPP
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_SIMD_HPP
+#define SYNCPS_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/*
+ * Array kernels for the IBLT's per-cell arrays (see iblt.hpp).
+ *
+ * On x86 built with gcc or clang the AVX2 or SSE2 kernels are picked
+ * at runtime from what the cpu supports, so no -m flags are needed.
+ * Everywhere else, or when SYNCPS_NO_SIMD is defined, the scalar
+ * kernels are used.
+ */
+
+#if ! defined(SYNCPS_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) \
+    && defined(__GNUC__)
+#define SYNCPS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace syncps {
+namespace simd {
+
+// out[i] = a[i] - b[i]   ('out' may be 'a')
+using Sub32 = void (*)(int32_t* out, const int32_t* a, const int32_t* b, size_t n);
+// out[i] = a[i] ^ b[i]   ('out' may be 'a')
+using Xor32 = void (*)(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n);
+// true if a[i] == b[i] for all i
+using Equal32 = bool (*)(const uint32_t* a, const uint32_t* b, size_t n);
+
+struct Kernels
+{
+    const char* name;
+    Sub32 sub32;
+    Xor32 xor32;
+    Equal32 equal32;
+};
+
+static inline void sub32Scalar(int32_t* out, const int32_t* a, const int32_t* b,
+                               size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        // wrap like the unsigned arithmetic the vector kernels do
+        out[i] = int32_t(uint32_t(a[i]) - uint32_t(b[i]));
+    }
+}
+
+static inline void xor32Scalar(uint32_t* out, const uint32_t* a, const uint32_t* b,
+                               size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] ^ b[i];
+    }
+}
+
+static inline bool equal32Scalar(const uint32_t* a, const uint32_t* b, size_t n)
+{
+    return n == 0 || std::memcmp(a, b, n * sizeof(uint32_t)) == 0;
+}
+
+#ifdef SYNCPS_X86_SIMD
+
+__attribute__((target("sse2")))
+static inline void sub32Sse2(int32_t* out, const int32_t* a, const int32_t* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto va = _mm_loadu_si128((const __m128i*)(a + i));
+        auto vb = _mm_loadu_si128((const __m128i*)(b + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_sub_epi32(va, vb));
+    }
+    sub32Scalar(out + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static inline void xor32Sse2(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto va = _mm_loadu_si128((const __m128i*)(a + i));
+        auto vb = _mm_loadu_si128((const __m128i*)(b + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(va, vb));
+    }
+    xor32Scalar(out + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static inline bool equal32Sse2(const uint32_t* a, const uint32_t* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        auto va = _mm_loadu_si128((const __m128i*)(a + i));
+        auto vb = _mm_loadu_si128((const __m128i*)(b + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(va, vb)) != 0xFFFF) {
+            return false;
+        }
+    }
+    return equal32Scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static inline void sub32Avx2(int32_t* out, const int32_t* a, const int32_t* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto va = _mm256_loadu_si256((const __m256i*)(a + i));
+        auto vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_sub_epi32(va, vb));
+    }
+    sub32Scalar(out + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static inline void xor32Avx2(uint32_t* out, const uint32_t* a, const uint32_t* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto va = _mm256_loadu_si256((const __m256i*)(a + i));
+        auto vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(va, vb));
+    }
+    xor32Scalar(out + i, a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static inline bool equal32Avx2(const uint32_t* a, const uint32_t* b, size_t n)
+{
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        auto va = _mm256_loadu_si256((const __m256i*)(a + i));
+        auto vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        auto diff = _mm256_xor_si256(va, vb);
+        if (! _mm256_testz_si256(diff, diff)) {
+            return false;
+        }
+    }
+    return equal32Scalar(a + i, b + i, n - i);
+}
+
+#endif  // SYNCPS_X86_SIMD
+
+static inline Kernels selectKernels() noexcept
+{
+#ifdef SYNCPS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return {"avx2", sub32Avx2, xor32Avx2, equal32Avx2};
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return {"sse2", sub32Sse2, xor32Sse2, equal32Sse2};
+    }
+#endif
+    return {"scalar", sub32Scalar, xor32Scalar, equal32Scalar};
+}
+
+/**
+ * @brief the kernels for this cpu (chosen on first use)
+ */
+static inline const Kernels& kernels() noexcept
+{
+    static const Kernels k = selectKernels();
+    return k;
+}
+
+}  // namespace simd
+}  // namespace syncps
+
+#endif  // SYNCPS_SIMD_HPP
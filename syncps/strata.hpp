@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_STRATA_HPP
+#define SYNCPS_STRATA_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include <ndn-cxx/name.hpp>
+
+#include "iblt.hpp"
+
+namespace syncps {
+
+/**
+ * @brief Strata estimator of the size of a set difference
+ *
+ * (Eppstein et al., "What's the Difference? Efficient Set
+ * Reconciliation without Prior Context", SIGCOMM 2011.)
+ *
+ * Keys are split into strata by the number of trailing zeros of a
+ * hash so stratum i holds about 1/2^(i+1) of them. Each stratum is a
+ * small fixed size IBLT. Differencing two estimators stratum by stratum,
+ * from the sparsest down, until one fails to peel estimates the size of
+ * the set difference from the entries recovered so far. It's used when
+ * a difference is too big for the IBLTs being exchanged to find an IBLT
+ * size that will decode.
+ */
+class StrataEstimator
+{
+  public:
+    static constexpr size_t N_STRATA = 16;
+    static constexpr size_t STRATUM_CELLS = 10 * N_HASH;
+    static constexpr uint32_t STRATA_SEED = N_HASHCHECK + 1;
+
+    class Error : public std::runtime_error
+    {
+      public:
+        using std::runtime_error::runtime_error;
+    };
+
+    StrataEstimator() : m_strata(N_STRATA, IBLT::withCells(STRATUM_CELLS))
+    {
+        for (auto& s : m_strata) {
+            s.setCompression(Compression::none);
+        }
+    }
+
+    void insert(uint32_t key) { m_strata[stratum(key)].insert(key); }
+
+    void erase(uint32_t key) { m_strata[stratum(key)].erase(key); }
+
+    /**
+     * @brief estimate the size of the difference between this and 'other'
+     */
+    size_t estimate(const StrataEstimator& other) const
+    {
+        auto diff = IBLT::withCells(STRATUM_CELLS);
+        std::vector<uint32_t> have;
+        std::vector<uint32_t> need;
+        size_t count = 0;
+        for (size_t i = N_STRATA; i-- > 0; ) {
+            diff.setDifference(m_strata[i], other.m_strata[i]);
+            have.clear();
+            need.clear();
+            if (! diff.peel(have, need)) {
+                return std::max<size_t>(count, 1) << (i + 1);
+            }
+            count += have.size() + need.size();
+        }
+        return count;
+    }
+
+    void appendToName(ndn::Name& name) const { name.append(encode()); }
+
+    /**
+     * @brief Encode self as a name component
+     *
+     * The component value is the number of strata and the length of the
+     * uncompressed strata as varints followed by the zlib compressed
+     * strata. Each stratum is its (uncompressed) IBLT encoding preceded
+     * by its length as a varint.
+     */
+    ndn::name::Component encode() const
+    {
+        std::vector<uint8_t> raw;
+        for (const auto& s : m_strata) {
+            const auto& c = s.encode();
+            uint8_t len[MAX_VARINT32];
+            raw.insert(raw.end(), len, putVarint(len, c.value_size()));
+            raw.insert(raw.end(), c.value(), c.value() + c.value_size());
+        }
+        auto maxLen = 2 * MAX_VARINT32 + maxCompressedSize(Compression::zlib, raw.size());
+        auto& buf = codecScratch(maxLen);
+        uint8_t* p = putVarint(putVarint(buf.data(), N_STRATA), raw.size());
+        size_t len = p - buf.data();
+        len += compressBlock(Compression::zlib, raw.data(), raw.size(), p, maxLen - len);
+        return ndn::name::Component(buf.data(), len);
+    }
+
+    /**
+     * @brief Populate the strata from their name component encoding
+     *
+     * @throws Error if the encoding is corrupt
+     */
+    void initialize(const ndn::name::Component& strataName)
+    {
+        const uint8_t* wire = strataName.value();
+        const uint8_t* end = wire + strataName.value_size();
+        uint32_t nStrata, rawLen;
+        if (! (wire = getVarint(wire, end, nStrata)) || nStrata != N_STRATA ||
+            ! (wire = getVarint(wire, end, rawLen)) || rawLen > maxRawLen) {
+            BOOST_THROW_EXCEPTION(Error("Received strata cannot be decoded!"));
+        }
+        std::vector<uint8_t> raw(rawLen);
+        try {
+            decompressBlock(Compression::zlib, wire, end - wire, raw.data(), rawLen);
+            const uint8_t* p = raw.data();
+            const uint8_t* rawEnd = p + rawLen;
+            for (auto& s : m_strata) {
+                uint32_t len;
+                if (! (p = getVarint(p, rawEnd, len)) || len > size_t(rawEnd - p)) {
+                    BOOST_THROW_EXCEPTION(Error("Received strata cannot be decoded!"));
+                }
+                s.initialize(ndn::name::Component(p, len));
+                if (s.size() != STRATUM_CELLS) {
+                    BOOST_THROW_EXCEPTION(Error("Received strata cannot be decoded!"));
+                }
+                p += len;
+            }
+        } catch (const CodecError& e) {
+            BOOST_THROW_EXCEPTION(Error(std::string("Received strata cannot be decoded! ") + e.what()));
+        } catch (const IBLT::Error& e) {
+            BOOST_THROW_EXCEPTION(Error(std::string("Received strata cannot be decoded! ") + e.what()));
+        }
+    }
+
+  private:
+    static size_t stratum(uint32_t key) noexcept
+    {
+        uint32_t h = murmurHash3(STRATA_SEED, key);
+        return h == 0? N_STRATA - 1 : std::min<size_t>(__builtin_ctz(h), N_STRATA - 1);
+    }
+
+    // bound on the uncompressed strata accepted from a peer
+    static constexpr size_t maxRawLen = N_STRATA * (MAX_VARINT32 + 2 * MAX_VARINT32 + 1 +
+                                                   STRATUM_CELLS * (2 * MAX_VARINT32 + 8));
+
+    std::vector<IBLT> m_strata;
+};
+
+}  // namespace syncps
+
+#endif  // SYNCPS_STRATA_HPP
@@ -26,6 +26,7 @@
 #include <map>
 #include <random>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <ndn-cxx/face.hpp>
 #include <ndn-cxx/security/key-chain.hpp>
@@ -36,6 +37,12 @@
 #include <ndn-cxx/util/time.hpp>
 
 #include "iblt.hpp"
+#include "name-trie.hpp"
+#include "pub-table.hpp"
+#include "pub-verifier.hpp"
+#include "signer.hpp"
+#include "strata.hpp"
+#include "timing-wheel.hpp"
 
 namespace syncps
 {
@@ -56,6 +63,8 @@ constexpr int maxPubSize = 1300;    // max payload in Data (approximate)
 using namespace ndn::literals::time_literals;
 constexpr ndn::time::milliseconds maxPubLifetime = 1_s;
 constexpr ndn::time::milliseconds maxClockSkew = 1_s;
+// publication expiries that fall within a tick are handled together
+constexpr ndn::time::milliseconds expiryTick = 10_ms;
 
 /**
  * @brief app callback when new publications arrive
@@ -73,6 +82,62 @@ using PubPtr = std::shared_ptr<const Publication>;
 using VPubPtr = std::vector<PubPtr>;
 using FilterPubsCb = std::function<VPubPtr(VPubPtr&,VPubPtr&)>;
 
+/**
+ * @brief counters describing the work done by a SyncPubsub
+ */
+struct SyncCounters
+{
+    uint64_t ibltEncodes{};         // sync interests that (re)encoded the IBLT
+    uint64_t ibltEncodesSaved{};    // sync interests that reused the cached encoding
+    ndn::time::nanoseconds ibltEncodeTime{};   // total time spent encoding
+    uint64_t ibltDecodes{};         // peer IBLTs decoded from sync interests
+    uint64_t ibltDecodesSaved{};    // peer IBLTs found already decoded
+    uint64_t peelFailures{};        // differences that didn't fully peel
+    uint64_t ibltResizes{};         // adaptive changes to our IBLT size
+    uint64_t ibltRebuilds{};        // our IBLT rebuilt at a peer's size
+    uint64_t strataSent{};          // sync interests that carried our strata
+    uint64_t strataEstimates{};     // difference sizes estimated from strata
+    uint64_t recoveryInterests{};   // sync interests sent with a bigger IBLT
+    uint64_t segmentedReplies{};    // replies sent as more than one Data
+    uint64_t segmentsServed{};      // reply segments sent from the cache
+    uint64_t segmentsFetched{};     // reply segments we asked peers for
+    uint64_t interestSweeps{};      // passes over the pending interests
+    uint64_t sweepsCoalesced{};     // sweep requests merged into a pending one
+    uint64_t diffsSaved{};          // pending interests updated without a peel
+    uint64_t signBatches{};         // calls to the signer (a batch counts once)
+    uint64_t repliesFromCache{};    // replies re-sent without signing
+    uint64_t pubsVerified{};        // publications checked by the pub verifier
+    uint64_t pubsRejected{};        // publications that failed the check
+    uint64_t verifyCacheHits{};     // arrivals of a pub already being or failed checking
+};
+
+static inline std::ostream& operator<<(std::ostream& out, const SyncCounters& c)
+{
+    out << "ibltEncodes=" << c.ibltEncodes
+        << " ibltEncodesSaved=" << c.ibltEncodesSaved
+        << " ibltEncodeNs=" << c.ibltEncodeTime.count()
+        << " ibltDecodes=" << c.ibltDecodes
+        << " ibltDecodesSaved=" << c.ibltDecodesSaved
+        << " peelFailures=" << c.peelFailures
+        << " ibltResizes=" << c.ibltResizes
+        << " ibltRebuilds=" << c.ibltRebuilds
+        << " strataSent=" << c.strataSent
+        << " strataEstimates=" << c.strataEstimates
+        << " recoveryInterests=" << c.recoveryInterests
+        << " segmentedReplies=" << c.segmentedReplies
+        << " segmentsServed=" << c.segmentsServed
+        << " segmentsFetched=" << c.segmentsFetched
+        << " interestSweeps=" << c.interestSweeps
+        << " sweepsCoalesced=" << c.sweepsCoalesced
+        << " diffsSaved=" << c.diffsSaved
+        << " signBatches=" << c.signBatches
+        << " repliesFromCache=" << c.repliesFromCache
+        << " pubsVerified=" << c.pubsVerified
+        << " pubsRejected=" << c.pubsRejected
+        << " verifyCacheHits=" << c.verifyCacheHits;
+    return out;
+}
+
 /**
  * @brief sync a lifetime-bounded set of publications among
  *        an arbitrary set of nodes.
@@ -86,8 +151,8 @@ using FilterPubsCb = std::function<VPubPtr(VPubPtr&,VPubPtr&)>;
  * their name is a version number (local ms clock) that is used to bound the
  * pub lifetime. This component is added by 'publish' before the publication
  * is signed so it is protected against replay attacks. App publications
- * are signed by pubCertificate and external publications are verified by
- * pubValidator on arrival. (XXX not yet)
+ * are signed by pubCertificate and external publications are checked on
+ * arrival by the pub verifier (see setPubVerifier), if there is one.
  */
 
 class SyncPubsub
@@ -115,6 +180,8 @@ class SyncPubsub
         : m_face(face),
           m_syncPrefix(std::move(syncPrefix)),
           m_expectedNumEntries(expectedNumEntries),
+          m_minExpectedEntries(expectedNumEntries),
+          m_maxExpectedEntries(expectedNumEntries),
           m_validator(ndn::security::v2::getAcceptAllValidator()), //XXX
           m_scheduler(m_face.getIoService()),
           m_iblt(expectedNumEntries),
@@ -139,17 +206,19 @@ class SyncPubsub
      */
     SyncPubsub& publish(Publication&& pub)
     {
-        m_keyChain.sign(pub, m_signingInfo); //XXX
-        if (isKnown(pub)) {
+        m_signer->sign(pub, m_signingInfo); //XXX
+        ++m_counters.signBatches;
+        auto hash = hashPub(pub);
+        if (isKnown(hash)) {
             NDN_LOG_WARN("republish of '" << pub.getName() << "' ignored");
         } else {
             NDN_LOG_INFO("Publish: " << pub.getName());
             ++m_publications;
-            addToActive(std::move(pub), true);
+            addToActive(std::move(pub), hash, true);
             // new pub may let us respond to pending interest(s).
             if (! m_delivering) {
                 sendSyncInterest();
-                handleInterests();
+                requestSweep();
             }
         }
         return *this;
@@ -167,7 +236,7 @@ class SyncPubsub
     {
         // add to subscription dispatch table. NOTE that an existing
         // subscription to 'topic' will be changed to the new callback.
-        m_subscription[topic] = std::move(cb);
+        m_subscription.insert(topic, std::move(cb));
         NDN_LOG_INFO("subscribeTo: " << topic);
         return *this;
     }
@@ -228,6 +297,129 @@ class SyncPubsub
         return *this;
     }
 
+    /**
+     * @brief set the backend that signs publications and sync Data
+     *
+     * The default signs each packet with the KeyChain.
+     */
+    SyncPubsub& setSigner(std::unique_ptr<Signer> signer)
+    {
+        m_signer = std::move(signer);
+        return *this;
+    }
+
+    /**
+     * @brief sign the Data of a segmented reply with one signature
+     *
+     * Uses a MerkleSigner (see signer.hpp) so each reply costs one
+     * signature however many segments it has. Peers' validators must
+     * understand its signature type.
+     */
+    SyncPubsub& setBatchSigning(bool enable)
+    {
+        if (enable) {
+            m_signer = std::make_unique<MerkleSigner>(m_keyChain);
+        } else {
+            m_signer = std::make_unique<KeyChainSigner>(m_keyChain);
+        }
+        return *this;
+    }
+
+    /**
+     * @brief set the compression used for the IBLT in our sync interests
+     *
+     * The compression is carried in the encoding so peers can decode any
+     * mode that was compiled into their copy of syncps.
+     *
+     * @param c the compression to use (zlib if never set)
+     * @throws IBLT::Error if 'c' isn't supported by this build
+     */
+    SyncPubsub& setIbltCompression(Compression c)
+    {
+        m_iblt.setCompression(c);
+        return *this;
+    }
+
+    /**
+     * @brief let the IBLT size adapt to the observed set differences
+     *
+     * The IBLT starts at expectedNumEntries (from the constructor). It
+     * doubles, up to maxEntries, when a peer's difference fails to peel
+     * or holds more entries than our IBLT is sized for. (A peer that
+     * grew its IBLT lets us measure differences bigger than our own
+     * size.) It halves, never below the starting size, when every
+     * difference over a window of interests would have fit in a quarter
+     * of the current size.
+     *
+     * The size is carried in the IBLT encoding. A peer IBLT of a
+     * different size is compared against ours rebuilt at its size, so
+     * nodes with different sizes can still sync.
+     *
+     * @param maxEntries largest expectedNumEntries to grow to
+     */
+    SyncPubsub& setAdaptiveIbltSize(size_t maxEntries)
+    {
+        m_maxExpectedEntries = std::max<size_t>(maxEntries, m_minExpectedEntries);
+        return *this;
+    }
+
+    /**
+     * @brief reply with all the publications a peer needs
+     *
+     * Normally a reply to a sync interest is one Data holding as many of
+     * the publications the peer needs as fit and the peer gets the rest
+     * with further sync interests. With segmented replies the whole set
+     * (up to maxSegments Data) is sent as a numbered series: the reply
+     * to the sync interest is segment 0 and its FinalBlockId gives the
+     * last segment. Every peer that hears a sync interest may answer
+     * it, each with its own set, so the segments are named
+     * /<sync-prefix>/<IBF>/<reply>/<segment> where <reply> is a hash of
+     * the reply's content. The peer fetches the others all at once
+     * under the name of the segment 0 it got, so they come from the
+     * same reply, and they're answered from a cache of it.
+     */
+    SyncPubsub& setSegmentedReplies(bool enable)
+    {
+        m_segmentedReplies = enable;
+        return *this;
+    }
+
+    /**
+     * @brief check each publication that arrives from a peer
+     *
+     * A publication is only added to the active set and delivered to
+     * its subscriber if 'verify' returns true. With 'nThreads' zero
+     * 'verify' is called inline as each publication arrives. Otherwise
+     * it is called on a pool of 'nThreads' threads (see pub-verifier.hpp)
+     * so the face thread isn't held up by crypto and 'verify' must be
+     * thread safe. Publications are delivered in the order they arrived
+     * as their checks complete.
+     *
+     * A publication is checked at most once: one that arrives again from
+     * another peer while it's being checked, or after it failed, is
+     * dropped without checking it again. Replacing the check drops the
+     * publications still being checked by the old pool; they're checked
+     * again if they arrive again.
+     *
+     * @param verify the check (none if empty)
+     * @param nThreads size of the thread pool
+     */
+    SyncPubsub& setPubVerifier(VerifyPubCb verify, size_t nThreads = 0)
+    {
+        m_verifier.reset();
+        for (auto hash : m_verifying) {
+            m_verifyCache.erase(hash);
+        }
+        m_verifying.clear();
+        m_verifyPub = std::move(verify);
+        if (m_verifyPub && nThreads > 0) {
+            m_verifier = std::make_unique<PubVerifier>(m_face.getIoService(), m_verifyPub,
+                                [this](auto& results) { onVerified(results); },
+                                nThreads);
+        }
+        return *this;
+    }
+
     /**
      * @brief set packet validator
      *
@@ -246,6 +438,8 @@ class SyncPubsub
 
     const ndn::security::v2::Validator& getValidator() { return m_validator; }
 
+    const SyncCounters& getCounters() const { return m_counters; }
+
    private:
 
     /**
@@ -267,6 +461,9 @@ class SyncPubsub
      *        to our peers.
      *
      * Creates & sends interest of the form: /<sync-prefix>/<own-IBF>
+     * or, when recovering from a large set difference (see recover()),
+     * /<sync-prefix>/<own-IBF>/<own-strata>. While recovering the IBF
+     * is sized for the estimated difference rather than m_iblt's size.
      */
     void sendSyncInterest()
     {
@@ -279,9 +476,30 @@ class SyncPubsub
         reExpressSyncInterest();
 
         // Build and ship the interest. Format is
-        // /<sync-prefix>/<ourLatestIBF>
+        // /<sync-prefix>/<ourLatestIBF>[/<ourStrata>]
         ndn::Name name = m_syncPrefix;
-        m_iblt.appendToName(name);
+        const IBLT& iblt = m_recoverCells > m_iblt.size()?
+                                ibltOfSize(m_recoverCells) : m_iblt;
+        if (iblt.isEncoded()) {
+            ++m_counters.ibltEncodesSaved;
+        } else {
+            auto start = ndn::time::steady_clock::now();
+            iblt.encode();
+            m_counters.ibltEncodeTime += ndn::time::steady_clock::now() - start;
+            ++m_counters.ibltEncodes;
+        }
+        iblt.appendToName(name);
+        if (m_recoverCells != 0) {
+            ++m_counters.recoveryInterests;
+            if (--m_recoverInterests == 0) {
+                m_recoverCells = 0;
+            }
+        }
+        if (m_sendStrata) {
+            m_strata.appendToName(name);
+            m_sendStrata = false;
+            ++m_counters.strataSent;
+        }
 
         ndn::Interest syncInterest(name);
         m_currentInterest = ndn::random::generateWord32();
@@ -311,6 +529,19 @@ class SyncPubsub
             m_scheduler.schedule(3_ms, [this]{ sendSyncInterest(); });
     }
 
+    /**
+     * @brief A sync interest we couldn't answer yet and its difference
+     *        with our set
+     */
+    struct PendingInterest
+    {
+        ndn::time::system_clock::TimePoint expires;
+        std::vector<uint32_t> have{};   // sorted
+        std::vector<uint32_t> need{};   // sorted
+        bool peeled{false};             // if not, have & need are incomplete
+        size_t seen{};                  // m_newHashes already in have & need
+    };
+
     /**
      * @brief callback to Process a new sync interest from NFD
      *
@@ -328,28 +559,68 @@ class SyncPubsub
             return;
         }
         const ndn::Name& name = interest.getName();
-        NDN_LOG_DEBUG("onSyncInterest " << std::hex << interest.getNonce() << "/"
-                      << hashIBLT(name));
-
-        if (name.size() - prefixName.size() != 1) {
+        if (name.size() > prefixName.size() + 1 && name[-1].isSegment()) {
+            sendSegment(name);
+            return;
+        }
+        if (auto n = name.size() - prefixName.size(); n != 1 && n != 2) {
             NDN_LOG_INFO("invalid sync interest: " << interest);
             return;
         }
-        if (!  handleInterest(name)) {
+        NDN_LOG_DEBUG("onSyncInterest " << std::hex << interest.getNonce() << "/"
+                      << hashIBLT(name));
+        PendingInterest pi{ndn::time::system_clock::now() + m_syncInterestLifetime};
+        pi.seen = m_newHashes.size();
+        if (!  handleInterest(name, pi)) {
             // couldn't handle interest immediately - remember it until
-            // we satisfy it or it times out;
-            m_interests[name] = ndn::time::system_clock::now() +
-                                    m_syncInterestLifetime;
+            // we satisfy it or it times out. Its difference is peeled
+            // (and the IBLT size adapted to it) only here, on arrival.
+            // After that the difference is kept up to date from new
+            // publications (see handleInterests).
+            m_interests[name] = std::move(pi);
+        } else if (m_interests.count(name) == 0) {
+            releaseDecoded(name);
+        }
+    }
+
+    /**
+     * @brief Arrange for the pending interests to be re-evaluated
+     *
+     * Requests made before the sweep runs are merged into it so a burst
+     * of publications results in one pass over the pending interests.
+     */
+    void requestSweep()
+    {
+        if (m_sweepScheduled) {
+            ++m_counters.sweepsCoalesced;
+            return;
         }
+        m_sweepScheduled = true;
+        m_sweep = m_scheduler.schedule(0_ms, [this] { handleInterests(); });
     }
 
     void handleInterests()
     {
         NDN_LOG_DEBUG("handleInterests");
+        ++m_counters.interestSweeps;
+        m_sweepScheduled = false;
+        std::vector<uint32_t> added;
+        added.swap(m_newHashes);
         auto now = ndn::time::system_clock::now();
         for (auto i = m_interests.begin(); i != m_interests.end(); ) {
-            const auto& [name, expires] = *i;
-            if (expires <= now || handleInterest(name)) {
+            auto& [name, pi] = *i;
+            // An interest whose difference didn't peel isn't peeled
+            // again: its IBLT hasn't changed so a bigger difference with
+            // it wouldn't peel either. It gets the pubs added since, as
+            // one that peeled does, or waits until it expires.
+            bool done = pi.expires <= now;
+            if (! done && updateDifference(pi, added)) {
+                ++m_counters.diffsSaved;
+                done = sendReply(name, pi.have);
+            }
+            pi.seen = 0;
+            if (done) {
+                releaseDecoded(name);
                 i = m_interests.erase(i);
             } else {
                 ++i;
@@ -357,44 +628,88 @@ class SyncPubsub
         }
     }
 
-    bool handleInterest(const ndn::Name& name)
+    /**
+     * @brief Update a pending interest's difference with pubs added since
+     *        it was computed
+     *
+     * A new pub the peer has leaves its 'need' set; any other is one
+     * more that we have and the peer doesn't. (If the difference didn't
+     * peel, 'need' is incomplete so a pub the peer has may be sent to
+     * it; the peer drops it as known.)
+     *
+     * @return true if 'have' grew
+     */
+    static bool updateDifference(PendingInterest& pi, const std::vector<uint32_t>& added)
+    {
+        bool grew = false;
+        for (size_t i = pi.seen; i < added.size(); i++) {
+            const auto hash = added[i];
+            if (auto n = std::lower_bound(pi.need.begin(), pi.need.end(), hash);
+                n != pi.need.end() && *n == hash) {
+                pi.need.erase(n);
+                continue;
+            }
+            if (auto h = std::lower_bound(pi.have.begin(), pi.have.end(), hash);
+                h == pi.have.end() || *h != hash) {
+                pi.have.insert(h, hash);
+                grew = true;
+            }
+        }
+        return grew;
+    }
+
+    bool handleInterest(const ndn::Name& name, PendingInterest& pi)
     {
         // 'Peeling' the difference between the peer's iblt & ours gives
         // two sets:
         //   have - (hashes of) items we have that they don't
         //   need - (hashes of) items we need that they have
-        IBLT iblt(m_expectedNumEntries);
-        try {
-            iblt.initialize(name.get(-1));
-        } catch (const std::exception& e) {
-            NDN_LOG_WARN(e.what());
+        const IBLT* iblt = decodeInterest(name);
+        if (iblt == nullptr) {
             return true;
         }
-        std::set<uint32_t> have;
-        std::set<uint32_t> need;
-        (m_iblt - iblt).listEntries(have, need);
+        auto& have = pi.have;
+        auto& need = pi.need;
+        have.clear();
+        need.clear();
+        m_diff.setDifference(ibltOfSize(iblt->size()), *iblt);
+        pi.peeled = m_diff.peel(have, need);
+        adaptIbltSize(pi.peeled, have.size() + need.size());
+        recover(name, pi, iblt->size());
         NDN_LOG_DEBUG("handleInterest " << std::hex << hashIBLT(name)
                       << " need " << need.size() << ", have " << have.size());
+        return sendReply(name, have);
+    }
 
+    /**
+     * @brief Reply to a sync interest with pubs the peer doesn't have
+     *
+     * @param name the sync interest's name
+     * @param have (hashes of) items we have that the peer doesn't
+     * @return true if a reply was sent
+     */
+    bool sendReply(const ndn::Name& name, const std::vector<uint32_t>& have)
+    {
         // If we have things the other side doesn't, send as many as
         // will fit in one Data. Make two lists of needed, active publications:
         // ones we published and ones published by others.
 
         VPubPtr pOurs, pOthers;
         for (const auto hash : have) {
-            if (auto h = m_hash2pub.find(hash); h != m_hash2pub.end()) {
-                // 2^0 bit of p->second is =0 if pub expired; 2^1 bit is 1 if we
-                // did publication.
-                if (const auto p = m_active.find(h->second); p != m_active.end()
-                    && (p->second & 1U) != 0) {
-                    ((p->second & 2U) != 0? &pOurs : &pOthers)->push_back(h->second);
-                }
+            // 2^0 bit of flags is =0 if pub expired; 2^1 bit is 1 if we
+            // did publication; 2^2 bit is 1 while the pub is in m_iblt.
+            if (const auto e = m_pubs.find(hash); e != nullptr && (e->flags & 1U) != 0) {
+                ((e->flags & 2U) != 0? &pOurs : &pOthers)->push_back(e->pub);
             }
         }
         pOurs = m_filterPubs(pOurs, pOthers);
         if (pOurs.empty()) {
             return false;
         }
+        if (m_segmentedReplies) {
+            sendSegmentedData(name, pOurs);
+            return true;
+        }
         ndn::Block pubs(tlv::syncpsContent);
         for (const auto& p : pOurs) {
             NDN_LOG_DEBUG("Send pub " << p->getName());
@@ -408,6 +723,215 @@ class SyncPubsub
         return true;
     }
 
+    /**
+     * @brief Return the decoded IBLT of a sync interest
+     *
+     * Decoded IBLTs are cached (keyed by the hash of the IBLT name
+     * component) until releaseDecoded(), which is done when the interest
+     * leaves m_interests, so a repeat of a pending interest (a peer
+     * re-expressing it, or peers with the same set) isn't decompressed
+     * and decoded again. The tables are recycled through a pool.
+     *
+     * @return the IBLT or nullptr if it couldn't be decoded
+     */
+    const IBLT* decodeInterest(const ndn::Name& name)
+    {
+        auto h = hashIBLT(name);
+        if (auto d = m_decoded.find(h); d != m_decoded.end()) {
+            ++m_counters.ibltDecodesSaved;
+            return &d->second;
+        }
+        IBLT iblt(0);
+        if (m_ibltPool.empty()) {
+            iblt = IBLT(m_expectedNumEntries);
+        } else {
+            iblt = std::move(m_ibltPool.back());
+            m_ibltPool.pop_back();
+        }
+        ++m_counters.ibltDecodes;
+        try {
+            iblt.initialize(name.get(m_syncPrefix.size()));
+        } catch (const std::exception& e) {
+            NDN_LOG_WARN(e.what());
+            m_ibltPool.push_back(std::move(iblt));
+            return nullptr;
+        }
+        return &m_decoded.emplace(h, std::move(iblt)).first->second;
+    }
+
+    /**
+     * @brief Drop the cached decode of a sync interest's IBLT
+     */
+    void releaseDecoded(const ndn::Name& name)
+    {
+        if (auto d = m_decoded.find(hashIBLT(name)); d != m_decoded.end()) {
+            m_ibltPool.push_back(std::move(d->second));
+            m_decoded.erase(d);
+        }
+    }
+
+    /**
+     * @brief Return our IBLT with 'cells' cells
+     *
+     * If a peer is using a different size, our IBLT is rebuilt at that
+     * size from the keys it holds. Rebuilds are kept, by size, until our
+     * IBLT next changes so peers using different sizes don't make us
+     * rebuild on every interest.
+     */
+    const IBLT& ibltOfSize(size_t cells)
+    {
+        if (cells == m_iblt.size()) {
+            return m_iblt;
+        }
+        if (m_ibltResizedVersion != m_ibltVersion ||
+            (m_ibltResized.size() >= maxResizedIblts && m_ibltResized.count(cells) == 0)) {
+            m_ibltResized.clear();
+            m_ibltResizedVersion = m_ibltVersion;
+        }
+        auto [r, added] = m_ibltResized.try_emplace(cells, 0);
+        if (added) {
+            r->second = IBLT::withCells(cells);
+            fillIblt(r->second);
+            ++m_counters.ibltRebuilds;
+        }
+        return r->second;
+    }
+
+    /**
+     * @brief insert every key that's in m_iblt into 'iblt'
+     */
+    void fillIblt(IBLT& iblt) const
+    {
+        m_pubs.forEach([&iblt](const auto& e) {
+            if ((e.flags & 4U) != 0) {
+                iblt.insert(e.hash);
+            }
+        });
+    }
+
+    /**
+     * @brief adaptive IBLT sizing (see setAdaptiveIbltSize)
+     *
+     * @param peeled true if the last difference peeled completely
+     * @param diffSize number of entries in the difference
+     */
+    void adaptIbltSize(bool peeled, size_t diffSize)
+    {
+        if (! peeled) {
+            ++m_counters.peelFailures;
+        }
+        if (m_maxExpectedEntries == m_minExpectedEntries) {
+            return;
+        }
+        auto want = m_expectedNumEntries;
+        if (! peeled || diffSize > m_expectedNumEntries) {
+            want *= 2;
+            m_adaptCount = 0;
+            m_adaptMaxDiff = 0;
+        } else {
+            m_adaptMaxDiff = std::max(m_adaptMaxDiff, diffSize);
+            if (++m_adaptCount >= adaptWindow) {
+                if (m_adaptMaxDiff * 4 < m_expectedNumEntries) {
+                    want /= 2;
+                }
+                m_adaptCount = 0;
+                m_adaptMaxDiff = 0;
+            }
+        }
+        want = std::clamp<size_t>(want, m_minExpectedEntries, m_maxExpectedEntries);
+        if (want == m_expectedNumEntries) {
+            return;
+        }
+        NDN_LOG_INFO("IBLT resize " << m_expectedNumEntries << " -> " << want);
+        m_expectedNumEntries = want;
+        IBLT iblt(want);
+        iblt.setCompression(m_iblt.getCompression());
+        fillIblt(iblt);
+        m_iblt = std::move(iblt);
+        ++m_ibltVersion;
+        ++m_counters.ibltResizes;
+        // let peers see the new size
+        sendSyncInterestSoon();
+    }
+
+    /**
+     * @brief Recover from a set difference too big for the IBLTs exchanged
+     *
+     * If the difference didn't peel, its size is estimated from the
+     * peer's strata when the interest carried them. Otherwise our strata
+     * are sent in our next interest so the peer can make the estimate.
+     * When the (exact or estimated) difference is too big for our IBLT to
+     * decode, our next few interests carry an IBLT sized for it (with
+     * some slack for estimation error, up to maxRecoverEntries). A
+     * difference that didn't peel gets at least twice the cells of the
+     * IBLT it failed with, whatever the estimate, so an estimate that's
+     * too low can't leave the peers stuck at a size that doesn't peel.
+     *
+     * While recovering, a peer whose difference with us peeled but has
+     * pubs we lack may not have been able to peel our last interest
+     * (sent when the difference was bigger) and won't peel it again (see
+     * handleInterests), so it's sent a new one.
+     *
+     * @param name the sync interest's name
+     * @param pi its difference with our set
+     * @param ibltCells number of cells in the interest's IBLT
+     */
+    void recover(const ndn::Name& name, const PendingInterest& pi, size_t ibltCells)
+    {
+        const auto maxCells = IBLT::cellsFor(maxRecoverEntries);
+        const bool peeled = pi.peeled;
+        size_t diffSize = pi.have.size() + pi.need.size();
+        size_t cells = 0;
+        if (! peeled) {
+            cells = std::min(ibltCells * 2, maxCells);
+            if (name.size() <= m_syncPrefix.size() + 1) {
+                m_sendStrata = true;
+            } else {
+                try {
+                    m_peerStrata.initialize(name.get(m_syncPrefix.size() + 1));
+                    diffSize = m_strata.estimate(m_peerStrata);
+                    ++m_counters.strataEstimates;
+                    diffSize += diffSize / 2;
+                } catch (const std::exception& e) {
+                    NDN_LOG_WARN(e.what());
+                    diffSize = 0;
+                }
+            }
+        }
+        cells = std::max(cells, IBLT::cellsFor(std::min(diffSize, maxRecoverEntries)));
+        const bool grow = cells > m_iblt.size() && cells > m_recoverCells;
+        if (grow) {
+            NDN_LOG_INFO("recover: difference " << diffSize << " sending " << cells
+                         << " cell IBLTs");
+            m_recoverCells = cells;
+            m_recoverInterests = recoverInterests;
+        }
+        // A difference that didn't peel gets our next interest now even
+        // if its IBLT can't be bigger: replies may have shrunk the
+        // difference since the peer sent its interest.
+        if (grow || ! peeled || (m_recoverCells != 0 && ! pi.need.empty())) {
+            sendSyncInterestSoon();
+        }
+    }
+
+    void ibltInsert(PubTable<PubPtr>::Entry& e)
+    {
+        m_iblt.insert(e.hash);
+        m_strata.insert(e.hash);
+        e.flags |= 4U;
+        ++m_ibltVersion;
+    }
+
+    void ibltErase(uint32_t hash)
+    {
+        m_iblt.erase(hash);
+        m_strata.erase(hash);
+        if (auto e = m_pubs.find(hash); e != nullptr) {
+            e->flags &=~ 4U;
+        }
+        ++m_ibltVersion;
+    }
+
     /**
      * @brief Send a sync data packet responding to a sync interest.
      *
@@ -421,10 +945,196 @@ class SyncPubsub
     void sendSyncData(const ndn::Name& name, const ndn::Block& pubs)
     {
         NDN_LOG_DEBUG("sendSyncData: " << name);
+        // the same interest with the same reply content gets the Data we
+        // signed last time if it's still fresh
+        auto content = murmurHash3(N_HASHCHECK, pubs.wire(), pubs.size());
+        if (sendCachedReply(name, content)) {
+            return;
+        }
         auto data = std::make_shared<ndn::Data>();
         data->setName(name).setContent(pubs).setFreshnessPeriod(maxPubLifetime / 2);
-        m_keyChain.sign(*data, m_signingInfo);
+        m_signer->sign(*data, m_signingInfo);
+        ++m_counters.signBatches;
         m_face.put(*data);
+        cacheReply(name, content, std::move(data));
+    }
+
+    /**
+     * @brief Resend the Data we signed for the same reply to the same
+     *        interest, if it's still fresh
+     *
+     * @param name    the sync interest's name
+     * @param content hash of the reply's content
+     * @return true if the cached Data was sent
+     */
+    bool sendCachedReply(const ndn::Name& name, uint32_t content)
+    {
+        auto r = m_replies.find(name);
+        if (r == m_replies.end() || r->second.content != content ||
+            r->second.expires <= ndn::time::steady_clock::now()) {
+            return false;
+        }
+        ++m_counters.repliesFromCache;
+        m_face.put(*r->second.data);
+        return true;
+    }
+
+    void cacheReply(const ndn::Name& name, uint32_t content,
+                    std::shared_ptr<const ndn::Data> data)
+    {
+        auto now = ndn::time::steady_clock::now();
+        if (m_replies.size() >= maxCachedReplies) {
+            for (auto r = m_replies.begin(); r != m_replies.end(); ) {
+                r = r->second.expires <= now? m_replies.erase(r) : std::next(r);
+            }
+            if (m_replies.size() >= maxCachedReplies) {
+                m_replies.clear();
+            }
+        }
+        m_replies[name] = {content, now + maxPubLifetime / 2, std::move(data)};
+    }
+
+    /**
+     * @brief Send 'pubs' as a segmented reply to a sync interest
+     *
+     * The pubs are packed into Data of about maxPubSize, named
+     * <name>/<hash of their content>/<segment>. Segment 0 is sent now
+     * and all the segments are cached for the freshness period to
+     * answer the peer's interests for the others. A reply that fits in
+     * one segment goes in the cache of single Data replies (see
+     * sendSyncData) so a repeat of the interest isn't signed again.
+     *
+     * @param name  the name of the sync interest
+     * @param pubs  publications the peer needs
+     */
+    void sendSegmentedData(const ndn::Name& name, const VPubPtr& pubs)
+    {
+        std::vector<ndn::Block> contents;
+        ndn::Block content(tlv::syncpsContent);
+        size_t len = 0;
+        for (const auto& p : pubs) {
+            NDN_LOG_DEBUG("Send pub " << p->getName());
+            const auto& wire = p->wireEncode();
+            content.push_back(wire);
+            if ((len += wire.size()) >= maxPubSize) {
+                content.encode();
+                contents.push_back(std::move(content));
+                content = ndn::Block(tlv::syncpsContent);
+                len = 0;
+                if (contents.size() == maxSegments) {
+                    break;
+                }
+            }
+        }
+        if (len != 0) {
+            content.encode();
+            contents.push_back(std::move(content));
+        }
+        uint32_t hash = 0;
+        for (const auto& c : contents) {
+            hash = murmurHash3(hash, c.wire(), c.size());
+        }
+        auto reply = ndn::Name(name).appendNumber(hash);
+        if (auto s = m_segments.find(reply); s != m_segments.end()) {
+            // same reply to the same interest: resend what we signed
+            ++m_counters.repliesFromCache;
+            m_face.put(*s->second.segments.front());
+            return;
+        }
+        if (contents.size() == 1 && sendCachedReply(name, hash)) {
+            return;
+        }
+        auto last = ndn::name::Component::fromSegment(contents.size() - 1);
+        DataBatch segments;
+        for (size_t i = 0; i < contents.size(); i++) {
+            auto data = std::make_shared<ndn::Data>();
+            data->setName(ndn::Name(reply).appendSegment(i))
+                 .setContent(contents[i])
+                 .setFreshnessPeriod(maxPubLifetime / 2);
+            data->setFinalBlock(last);
+            segments.push_back(std::move(data));
+        }
+        m_signer->sign(segments, m_signingInfo);
+        ++m_counters.signBatches;
+        NDN_LOG_DEBUG("sendSegmentedData: " << name << " " << segments.size()
+                      << " segments");
+        m_face.put(*segments.front());
+        if (segments.size() == 1) {
+            cacheReply(name, hash, std::move(segments.front()));
+            return;
+        }
+        ++m_counters.segmentedReplies;
+        auto& cached = m_segments[reply];
+        cached.segments = std::move(segments);
+        cached.expiry = m_scheduler.schedule(maxPubLifetime / 2,
+                                             [this, reply] { m_segments.erase(reply); });
+    }
+
+    /**
+     * @brief Answer an interest for a segment of a reply from the cache
+     */
+    void sendSegment(const ndn::Name& name)
+    {
+        auto s = m_segments.find(name.getPrefix(-1));
+        if (s == m_segments.end()) {
+            NDN_LOG_DEBUG("no cached reply for " << name);
+            return;
+        }
+        if (auto seg = name[-1].toSegment(); seg < s->second.segments.size()) {
+            ++m_counters.segmentsServed;
+            m_face.put(*s->second.segments[seg]);
+        }
+    }
+
+    /**
+     * @brief Fetch the rest of a segmented reply
+     *
+     * If 'data' is segment 0 of a segmented reply to 'interest', all the
+     * other segments are requested at once. Each is handled by
+     * onValidData as it arrives.
+     *
+     * @return true if segments are being fetched
+     */
+    bool fetchSegments(const ndn::Interest& interest, const ndn::Data& data)
+    {
+        const auto& dname = data.getName();
+        const auto& fb = data.getFinalBlock();
+        if (! fb || ! fb->isSegment() || dname.size() != interest.getName().size() + 2 ||
+            ! dname[-1].isSegment() || dname[-1].toSegment() != 0) {
+            return false;
+        }
+        // the rest of the reply segment 0 came from (see sendSegmentedData)
+        const auto reply = dname.getPrefix(-1);
+        auto last = std::min<uint64_t>(fb->toSegment(), maxSegments - 1);
+        for (uint64_t seg = 1; seg <= last; seg++) {
+            ndn::Interest segInterest(ndn::Name(reply).appendSegment(seg));
+            segInterest.setCanBePrefix(false)
+                .setMustBeFresh(true)
+                .setInterestLifetime(m_syncInterestLifetime);
+            ++m_segmentsPending;
+            ++m_counters.segmentsFetched;
+            m_face.expressInterest(segInterest,
+                    [this](auto i, auto d) {
+                        m_validator.validate(d,
+                            [this, i](auto d) { onValidData(i, d); segmentDone(); },
+                            [this](auto d, auto e) {
+                                NDN_LOG_INFO("Invalid: " << e << " Data " << d);
+                                segmentDone(); }); },
+                    [this](auto i, auto/*n*/) { NDN_LOG_INFO("Nack for " << i); segmentDone(); },
+                    [this](auto i) { NDN_LOG_INFO("Timeout for " << i); segmentDone(); });
+        }
+        return last != 0;
+    }
+
+    /**
+     * @brief Once all the segments of a reply are in, send a sync interest
+     *        to replace the one it consumed.
+     */
+    void segmentDone()
+    {
+        if (m_segmentsPending > 0 && --m_segmentsPending == 0) {
+            sendSyncInterest();
+        }
     }
 
     /**
@@ -462,81 +1172,186 @@ class SyncPubsub
                              e.type() << " ignored.");
                 continue;
             }
-            //XXX validate pub against schema here
+            // a pub's hash is of its wire encoding so a duplicate can be
+            // dropped before it's decoded.
+            auto hash = hashPub(e);
+            if (isKnown(hash)) {
+                NDN_LOG_DEBUG("ignore known " << std::hex << hash);
+                continue;
+            }
             Publication pub(e);
-            if (m_isExpired(pub) || isKnown(pub)) {
-                NDN_LOG_DEBUG("ignore expired or known " << pub.getName());
+            if (m_isExpired(pub)) {
+                NDN_LOG_DEBUG("ignore expired " << pub.getName());
                 continue;
             }
-            // we don't already have this publication so deliver it
-            // to the longest match subscription.
-            // XXX lower_bound goes one too far when doing longest
-            // prefix match. It would be faster to stick a marker on
-            // the end of subscription entries so this wouldn't happen.
-            // Also, it would be faster to do the comparison on the
-            // wire-format names (excluding the leading length value)
-            // rather than default of component-by-component.
-            const auto& p = addToActive(std::move(pub));
-            const auto& nm = p->getName();
-            auto sub = m_subscription.lower_bound(nm);
-            if ((sub != m_subscription.end() && sub->first.isPrefixOf(nm)) ||
-                (sub != m_subscription.begin() && (--sub)->first.isPrefixOf(nm))) {
-                NDN_LOG_DEBUG("deliver " << nm << " to " << sub->first);
-                sub->second(*p);
-            } else {
-                NDN_LOG_DEBUG("no sub for  " << nm);
+            if (m_verifyPub && ! verifyPub(pub, hash)) {
+                continue;
             }
+            deliverPub(std::move(pub), hash);
         }
 
         // We've delivered all the publications in the Data.
-        // If this is our currently active sync interest, send an
+        // If it's the first segment of a reply, fetch the rest (even if
+        // a sync interest has replaced the one it answers). Otherwise,
+        // if this is our currently active sync interest, send an
         // interest to replace the one consumed by the Data.
         // If deliveries resulted in new publications, try to satisfy
         // pending peer interests.
         m_delivering = false;
-        if (interest.getNonce() == m_currentInterest) {
+        if (! fetchSegments(interest, data) && interest.getNonce() == m_currentInterest) {
             sendSyncInterest();
         }
         if (initpubs != m_publications) {
-            handleInterests();
+            requestSweep();
+        }
+    }
+
+    /**
+     * @brief add a new publication from a peer to the active set and
+     *        deliver it to the longest match subscription.
+     */
+    void deliverPub(Publication&& pub, uint32_t hash)
+    {
+        const auto& p = addToActive(std::move(pub), hash);
+        const auto& nm = p->getName();
+        if (auto sub = m_subscription.longestPrefixMatch(nm); sub.value != nullptr) {
+            NDN_LOG_DEBUG("deliver " << nm << " to " << nm.getPrefix(sub.length));
+            (*sub.value)(*p);
+        } else {
+            NDN_LOG_DEBUG("no sub for  " << nm);
+        }
+    }
+
+    /**
+     * @brief Methods to check publications from peers (see setPubVerifier).
+     *
+     * m_verifyCache holds the hashes of the pubs being checked by
+     * m_verifier and of those that failed, with when they were added.
+     * The ones being checked are also in m_verifying. Pubs that passed
+     * are in m_pubs so they're caught by isKnown.
+     */
+
+    /**
+     * @return true if 'pub' can be delivered now. If it's handed to
+     *         m_verifier it's delivered by onVerified.
+     */
+    bool verifyPub(Publication& pub, uint32_t hash)
+    {
+        if (m_verifyCache.count(hash) != 0) {
+            NDN_LOG_DEBUG("ignore checked " << std::hex << hash);
+            ++m_counters.verifyCacheHits;
+            return false;
+        }
+        if (m_verifier) {
+            addToVerifyCache(hash);
+            m_verifying.insert(hash);
+            m_verifier->submit(hash, std::make_shared<Publication>(std::move(pub)));
+            return false;
+        }
+        ++m_counters.pubsVerified;
+        bool ok = false;
+        try {
+            ok = m_verifyPub(pub);
+        } catch (const std::exception&) {
+        }
+        if (! ok) {
+            rejectPub(pub, hash);
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Deliver the pubs m_verifier accepted (in the order they arrived)
+     */
+    void onVerified(std::vector<PubVerifier::Result>& results)
+    {
+        m_delivering = true;
+        auto initpubs = m_publications;
+        bool added = false;
+        for (auto& r : results) {
+            ++m_counters.pubsVerified;
+            m_verifying.erase(r.hash);
+            if (! r.ok) {
+                rejectPub(*r.pub, r.hash);
+                continue;
+            }
+            m_verifyCache.erase(r.hash);
+            // it may have expired while it was being checked
+            if (isKnown(r.hash) || m_isExpired(*r.pub)) {
+                continue;
+            }
+            deliverPub(std::move(*r.pub), r.hash);
+            added = true;
+        }
+        m_delivering = false;
+
+        // the sync interest that replaced the one these pubs came in on
+        // didn't have them so tell peers we have them now.
+        if (added && m_segmentsPending == 0) {
+            sendSyncInterestSoon();
+        }
+        if (initpubs != m_publications) {
+            requestSweep();
         }
     }
 
+    void rejectPub(const Publication& pub, uint32_t hash)
+    {
+        NDN_LOG_INFO("Invalid publication " << pub.getName());
+        ++m_counters.pubsRejected;
+        addToVerifyCache(hash);
+    }
+
+    void addToVerifyCache(uint32_t hash)
+    {
+        auto now = ndn::time::steady_clock::now();
+        if (m_verifyCache.size() >= maxVerifyCache) {
+            // pubs older than this are caught by m_isExpired
+            auto old = now - maxPubLifetime - maxClockSkew;
+            for (auto v = m_verifyCache.begin(); v != m_verifyCache.end(); ) {
+                v = v->second < old? m_verifyCache.erase(v) : std::next(v);
+            }
+        }
+        m_verifyCache[hash] = now;
+    }
+
     /**
      * @brief Methods to manage the active publication set.
      */
 
-    // publications are stored using a shared_ptr so we
-    // get to them indirectly via their hash.
+    // publications are stored in a table keyed by their hash.
 
-    uint32_t hashPub(const Publication& pub) const
+    // A publication is hashed once, when it's published or arrives, and
+    // the hash is kept with it in m_pubs.
+
+    uint32_t hashPub(const ndn::Block& wire) const
     {
-        const auto& b = pub.wireEncode();
-        return murmurHash3(N_HASHCHECK,
-                           std::vector<uint8_t>(b.wire(), b.wire() + b.size()));
+        return murmurHash3(N_HASHCHECK, wire.wire(), wire.size());
     }
 
-    bool isKnown(uint32_t h) const
+    uint32_t hashPub(const Publication& pub) const
     {
-        //return m_hash2pub.contains(h);
-        return m_hash2pub.find(h) != m_hash2pub.end();
+        return hashPub(pub.wireEncode());
     }
 
-    bool isKnown(const Publication& pub) const
+    bool isKnown(uint32_t h) const
     {
-        // publications are stored using a shared_ptr so we
-        // get to them indirectly via their hash.
-        return isKnown(hashPub(pub));
+        return m_pubs.contains(h);
     }
 
-    std::shared_ptr<Publication> addToActive(Publication&& pub, bool localPub = false)
+    std::shared_ptr<Publication> addToActive(Publication&& pub, uint32_t hash,
+                                             bool localPub = false)
     {
         NDN_LOG_DEBUG("addToActive: " << pub.getName());
-        auto hash = hashPub(pub);
-        auto p = std::make_shared<Publication>(pub);
-        m_active[p] = localPub? 3 : 1;
-        m_hash2pub[hash] = p;
-        m_iblt.insert(hash);
+        auto p = std::make_shared<Publication>(std::move(pub));
+        ibltInsert(m_pubs.insert(hash, p, localPub? 3 : 1));
+        if (! m_interests.empty()) {
+            // pending interests' differences get this at the next sweep
+            m_newHashes.push_back(hash);
+            if (m_newHashes.size() >= maxNewHashes) {
+                requestSweep();
+            }
+        }
 
         // We remove an expired publication from our active set at twice its pub
         // lifetime (the extra time is to prevent replay attacks enabled by clock
@@ -548,19 +1363,88 @@ class SyncPubsub
         // interval to prevent a peer with a late clock giving it back to us as soon
         // as we delete it.
 
-        m_scheduler.schedule(maxPubLifetime, [this, p] { m_active[p] &=~ 1U; });
-        m_scheduler.schedule(maxPubLifetime + maxClockSkew,
-            [this, hash] { m_iblt.erase(hash); sendSyncInterestSoon(); });
-        m_scheduler.schedule(maxPubLifetime * 2, [this, p] { removeFromActive(p); });
+        addExpiry({hash, Expiry::deactivate}, maxPubLifetime);
 
         return p;
     }
 
-    void removeFromActive(const PubPtr& p)
+    /**
+     * @brief Methods to expire publications.
+     *
+     * Each publication goes through the three steps described in
+     * addToActive. Rather than a scheduler event per step, the steps are
+     * kept in a timing wheel and a single scheduler event handles all
+     * of the steps due in the earliest tick. IBLT erases in a tick result
+     * in one sync interest.
+     */
+    struct Expiry
+    {
+        enum Step : uint8_t { deactivate, ibltErase, remove };
+        uint32_t hash;
+        Step step;
+    };
+
+    void addExpiry(Expiry&& e, ndn::time::nanoseconds delay)
     {
-        NDN_LOG_DEBUG("removeFromActive: " << (*p).getName());
-        m_active.erase(p);
-        m_hash2pub.erase(hashPub(*p));
+        m_expiry.add(ndn::time::steady_clock::now(), delay, std::move(e));
+        armExpiryTimer();
+    }
+
+    void armExpiryTimer()
+    {
+        if (m_expiry.empty()) {
+            return;
+        }
+        auto next = m_expiry.nextExpiry();
+        if (m_expiryTimerArmed && m_expiryTimerAt <= next) {
+            return;
+        }
+        m_expiryTimerArmed = true;
+        m_expiryTimerAt = next;
+        auto delay = std::max(next - ndn::time::steady_clock::now(),
+                              ndn::time::steady_clock::duration::zero());
+        m_expiryTimer = m_scheduler.schedule(
+                            ndn::time::duration_cast<ndn::time::nanoseconds>(delay),
+                            [this] { m_expiryTimerArmed = false; expirePubs(); });
+    }
+
+    void expirePubs()
+    {
+        bool erased = false;
+        auto now = ndn::time::steady_clock::now();
+        m_expiry.expire(now, [this, now, &erased](Expiry&& e) {
+            switch (e.step) {
+            case Expiry::deactivate:
+                if (auto a = m_pubs.find(e.hash); a != nullptr) {
+                    a->flags &=~ 1U;
+                }
+                e.step = Expiry::ibltErase;
+                m_expiry.add(now, maxClockSkew, std::move(e));
+                break;
+            case Expiry::ibltErase:
+                ibltErase(e.hash);
+                erased = true;
+                e.step = Expiry::remove;
+                m_expiry.add(now, maxPubLifetime * 2 - maxPubLifetime - maxClockSkew,
+                             std::move(e));
+                break;
+            case Expiry::remove:
+                removeFromActive(e.hash);
+                break;
+            }
+        });
+        if (erased) {
+            sendSyncInterestSoon();
+        }
+        armExpiryTimer();
+    }
+
+    void removeFromActive(uint32_t hash)
+    {
+        if (auto e = m_pubs.find(hash); e != nullptr) {
+            NDN_LOG_DEBUG("removeFromActive: " << e->pub->getName());
+            m_pubs.erase(hash);
+        }
     }
 
     /**
@@ -577,25 +1461,81 @@ class SyncPubsub
 
     uint32_t hashIBLT(const Name& n) const
     {
-        const auto& b = n[-1];
-        return murmurHash3(N_HASHCHECK,
-                           std::vector<uint8_t>(b.value_begin(), b.value_end()));
+        const auto& b = n[m_syncPrefix.size()];
+        return murmurHash3(N_HASHCHECK, b.value(), b.value_size());
     }
 
   private:
     ndn::Face& m_face;
     ndn::Name m_syncPrefix;
     uint32_t m_expectedNumEntries;
+    uint32_t m_minExpectedEntries;  // adaptive IBLT size range
+    uint32_t m_maxExpectedEntries;
     ndn::security::v2::Validator& m_validator;
     ndn::Scheduler m_scheduler;
-    std::map<const Name, ndn::time::system_clock::TimePoint> m_interests{};
+    // pending sync interests and their difference with our set
+    std::map<const Name, PendingInterest> m_interests{};
+    std::vector<uint32_t> m_newHashes{};    // pubs added since the last sweep
+    ndn::scheduler::ScopedEventId m_sweep;
+    bool m_sweepScheduled{false};
+    static constexpr size_t maxNewHashes = 1024;
     IBLT m_iblt;
+    IBLT m_diff{0};                 // scratch for m_iblt - peer's IBLT
+    // decoded IBLTs of pending interests (see decodeInterest)
+    std::unordered_map<uint32_t, IBLT> m_decoded{};
+    std::vector<IBLT> m_ibltPool{};
+    // m_iblt rebuilt at peers' sizes, by number of cells
+    std::unordered_map<size_t, IBLT> m_ibltResized{};
+    static constexpr size_t maxResizedIblts = 8;
+    uint64_t m_ibltVersion{};       // bumped whenever m_iblt changes
+    uint64_t m_ibltResizedVersion{};
+    size_t m_adaptCount{};          // interests in the current adapt window
+    size_t m_adaptMaxDiff{};        // largest difference in the window
+    static constexpr size_t adaptWindow = 32;
+    StrataEstimator m_strata{};     // estimator of the keys in m_iblt
+    StrataEstimator m_peerStrata{}; // scratch for a peer's strata
+    size_t m_recoverCells{};        // size of IBLT sent while recovering
+    uint32_t m_recoverInterests{};  // # interests left to send at that size
+    bool m_sendStrata{false};       // send our strata in the next interest
+    bool m_segmentedReplies{false}; // see setSegmentedReplies
+    // cached segmented replies, by sync interest name + content hash
+    struct SegmentedReply
+    {
+        DataBatch segments;
+        ndn::scheduler::ScopedEventId expiry;
+    };
+    std::map<const Name, SegmentedReply> m_segments{};
+    uint32_t m_segmentsPending{};   // segments of a reply still being fetched
+    static constexpr size_t maxSegments = 32;
+    TimingWheel<Expiry> m_expiry{expiryTick, maxPubLifetime + maxClockSkew};
+    ndn::scheduler::ScopedEventId m_expiryTimer;
+    ndn::time::steady_clock::TimePoint m_expiryTimerAt{};
+    bool m_expiryTimerArmed{false};
+    // bounds the recovery IBLT to keep sync interests under the max packet
+    // size (8800): its 450 cells take 5.4KB uncompressed (4.5KB with zlib
+    // when full) and the strata sent with it up to 3KB.
+    static constexpr size_t maxRecoverEntries = 300;
+    static constexpr uint32_t recoverInterests = 4;
     ndn::KeyChain m_keyChain;
     SigningInfo m_signingInfo;
+    std::unique_ptr<Signer> m_signer{std::make_unique<KeyChainSigner>(m_keyChain)};
+    // recently signed single Data replies, by sync interest name
+    struct CachedReply
+    {
+        uint32_t content;               // hash of the Data's content
+        ndn::time::steady_clock::TimePoint expires;
+        std::shared_ptr<const ndn::Data> data;
+    };
+    std::map<const Name, CachedReply> m_replies{};
+    static constexpr size_t maxCachedReplies = 64;
+    // checks pubs from peers (see setPubVerifier)
+    VerifyPubCb m_verifyPub{};
+    std::unordered_map<uint32_t, ndn::time::steady_clock::TimePoint> m_verifyCache{};
+    std::unordered_set<uint32_t> m_verifying{};     // submitted to m_verifier
+    static constexpr size_t maxVerifyCache = 4096;
     // currently active published items
-    std::unordered_map<std::shared_ptr<const Publication>, uint8_t> m_active{};
-    std::unordered_map<uint32_t, std::shared_ptr<const Publication>> m_hash2pub{};
-    std::map<const Name, UpdateCb> m_subscription{};
+    PubTable<PubPtr> m_pubs{};
+    NameTrie<UpdateCb> m_subscription{};
     IsExpiredCb m_isExpired;
     FilterPubsCb m_filterPubs;
     ndn::time::milliseconds m_syncInterestLifetime;
@@ -605,8 +1545,11 @@ class SyncPubsub
     uint32_t m_currentInterest{};   // nonce of current sync interest
     uint32_t m_publications{};      // # local publications
     uint32_t m_interestsSent{};
+    SyncCounters m_counters{};
     bool m_delivering{false};       // currently processing a Data
     bool m_registering{true};
+    // last so its threads stop before the rest of the state goes
+    std::unique_ptr<PubVerifier> m_verifier{};
 };
 
 }  // namespace syncps
@@ -0,0 +1,274 @@
+/* -*- Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil -*- */
+/*
+ * Threads for the eval harness' multi-threaded mode.
+ *
+ * In that mode the sync protocol runs on the face's thread, the
+ * application (publishing and handling updates) on its own io_service
+ * thread and the log writes on a third thread. They hand work to each
+ * other through single producer / single consumer lock-free queues.
+ */
+#ifndef EVAL_THREADS_HPP
+#define EVAL_THREADS_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <boost/asio/io_service.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/log/attributes/constant.hpp>
+#include <boost/log/attributes/scoped_attribute.hpp>
+#include <boost/log/sources/logger.hpp>
+#include <boost/log/sources/record_ostream.hpp>
+#include <boost/log/trivial.hpp>
+
+#include "log.hpp"
+
+/**
+ * Bounded single producer / single consumer queue.
+ *
+ * push() is only called by one thread and pop() by one (other) thread.
+ * N must be a power of two.
+ */
+template <typename T, size_t N = 4096>
+class SpscQueue
+{
+  static_assert((N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  // false if the queue is full
+  bool
+  push(T&& v)
+  {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_headCache == N) {
+      m_headCache = m_head.load(std::memory_order_acquire);
+      if (tail - m_headCache == N) {
+        return false;
+      }
+    }
+    m_buf[tail & (N - 1)] = std::move(v);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // false if the queue is empty
+  bool
+  pop(T& v)
+  {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tailCache) {
+      m_tailCache = m_tail.load(std::memory_order_acquire);
+      if (head == m_tailCache) {
+        return false;
+      }
+    }
+    v = std::move(m_buf[head & (N - 1)]);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::array<T, N> m_buf;
+  // the indices are on their own cache lines so the two threads don't
+  // contend. Each side caches the other's index and only reloads it when
+  // the queue looks full (or empty).
+  alignas(64) std::atomic<size_t> m_head{0};
+  size_t m_tailCache = 0;
+  alignas(64) std::atomic<size_t> m_tail{0};
+  size_t m_headCache = 0;
+};
+
+/**
+ * Runs tasks from one other thread on an io_service's thread.
+ *
+ * The tasks go through an SpscQueue. The consumer is only woken (by a
+ * post to its io_service) when the queue was idle so a burst of tasks
+ * costs one post.
+ */
+class TaskQueue
+{
+public:
+  explicit
+  TaskQueue(boost::asio::io_service& ios)
+    : m_ios(ios)
+  {
+  }
+
+  void
+  post(std::function<void()> task)
+  {
+    while (!m_queue.push(std::move(task))) {
+      std::this_thread::yield();
+    }
+    if (!m_scheduled.exchange(true)) {
+      m_ios.post([this] { run(); });
+    }
+  }
+
+private:
+  void
+  run()
+  {
+    // tasks pushed after this are either run below or post another run
+    m_scheduled.store(false);
+    std::function<void()> task;
+    while (m_queue.pop(task)) {
+      task();
+    }
+  }
+
+  boost::asio::io_service& m_ios;
+  SpscQueue<std::function<void()>> m_queue;
+  std::atomic<bool> m_scheduled{false};
+};
+
+/**
+ * Log lines written by a thread of their own.
+ *
+ * Lines are queued with the time they were made by one producer thread
+ * and written through Boost.Log with that time as their TimeStamp so
+ * the log reads as if they'd been written directly. If the log thread
+ * isn't running lines are written directly.
+ */
+class AsyncLog
+{
+public:
+  class Line
+  {
+  public:
+    explicit
+    Line(AsyncLog& log)
+      : m_log(log)
+    {
+    }
+
+    Line(const Line&) = delete;
+
+    ~Line()
+    {
+      m_log.write(m_ss.str());
+    }
+
+    template <typename V>
+    Line&
+    operator<<(const V& v)
+    {
+      m_ss << v;
+      return *this;
+    }
+
+  private:
+    AsyncLog& m_log;
+    std::ostringstream m_ss;
+  };
+
+  ~AsyncLog()
+  {
+    stop();
+  }
+
+  Line
+  line()
+  {
+    return Line(*this);
+  }
+
+  // an event for the binary log (see log.hpp) or its line of text
+  template <typename N>
+  void
+  event(evlog::Type type, const N& node, uint64_t seq, uint64_t pubNs = 0)
+  {
+    if (evlog::Log::get().active()) {
+      // the binary log is already written by a thread of its own
+      evlog::Log::get().event(type, node, seq, pubNs);
+      return;
+    }
+    line() << evlog::format(type, evlog::toString(node), seq, evlog::steadyNs(), pubNs);
+  }
+
+  void
+  start()
+  {
+    m_running = true;
+    m_thread = std::thread([this] { run(); });
+  }
+
+  // writes out what's queued then stops the log thread
+  void
+  stop()
+  {
+    if (m_thread.joinable()) {
+      m_stop = true;
+      m_thread.join();
+      m_running = false;
+    }
+  }
+
+private:
+  struct Entry
+  {
+    boost::posix_time::ptime time;
+    std::string msg;
+  };
+
+  void
+  write(std::string msg)
+  {
+    if (!m_running) {
+      BOOST_LOG_TRIVIAL(info) << msg;
+      return;
+    }
+    Entry e{boost::posix_time::microsec_clock::local_time(), std::move(msg)};
+    while (!m_queue.push(std::move(e))) {
+      std::this_thread::yield();
+    }
+  }
+
+  void
+  run()
+  {
+    namespace attrs = boost::log::attributes;
+    boost::log::sources::logger lg;
+    Entry e;
+    while (true) {
+      if (!m_queue.pop(e)) {
+        if (m_stop) {
+          return;
+        }
+        // the lines carry their own time so there's no hurry
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      BOOST_LOG_SCOPED_LOGGER_ATTR(lg, "TimeStamp",
+                                   attrs::constant<boost::posix_time::ptime>(e.time));
+      BOOST_LOG(lg) << e.msg;
+    }
+  }
+
+  SpscQueue<Entry> m_queue;
+  std::thread m_thread;
+  bool m_running = false;
+  std::atomic<bool> m_stop{false};
+};
+
+/**
+ * Busy the calling thread for 'us' microseconds (to model an
+ * application that does some work per update).
+ */
+inline void
+spinFor(int us)
+{
+  if (us <= 0) {
+    return;
+  }
+  auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(us);
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+#endif // EVAL_THREADS_HPP
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2019,  Pollere Inc.
+ *
+ * This file is part of syncps (NDN sync for pubsub).
+ * See AUTHORS.md for complete list of syncps authors and contributors.
+ *
+ * syncps is free software: you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation, either version 3 of the License, or (at your option) any later
+ * version.
+ *
+ * syncps is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR
+ * A PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * syncps, e.g., in COPYING.md file.  If not, see <http://www.gnu.org/licenses/>.
+ **/
+
+#ifndef SYNCPS_TIMING_WHEEL_HPP
+#define SYNCPS_TIMING_WHEEL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <ndn-cxx/util/time.hpp>
+
+namespace syncps {
+
+/**
+ * @brief Bucketed timing wheel
+ *
+ * Items are put in the slot of the tick at or after their expiry time
+ * and handed back a slot at a time by expire(), so everything expiring
+ * within a tick is handled as one batch. Items expire at most one tick
+ * late and never early. Adding and expiring an item is O(1); there is
+ * no per-item timer.
+ *
+ * The wheel covers 'horizon' (from the constructor). An item further
+ * out than that shares a slot with earlier ones and is passed over
+ * until its own tick comes round.
+ */
+template<typename T, typename Clock = ndn::time::steady_clock>
+class TimingWheel
+{
+  public:
+    using Duration = typename Clock::duration;
+    using TimePoint = typename Clock::time_point;
+
+    TimingWheel(Duration tick, Duration horizon)
+        : m_tick(tick.count()), m_slots(horizon.count() / tick.count() + 2)
+    {
+    }
+
+    bool empty() const noexcept { return m_size == 0; }
+
+    size_t size() const noexcept { return m_size; }
+
+    /**
+     * @brief add 'item' to expire 'delay' after 'now'
+     */
+    void add(TimePoint now, Duration delay, T item)
+    {
+        if (m_size == 0) {
+            m_current = floorTick(now);
+        }
+        int64_t t = std::max(ceilTick(now + delay), m_current + 1);
+        m_slots[t % m_slots.size()].push_back({t, std::move(item)});
+        ++m_size;
+    }
+
+    /**
+     * @brief time of the next non-empty slot (only valid if ! empty())
+     *
+     * This is no later than the earliest expiry.
+     */
+    TimePoint nextExpiry() const noexcept
+    {
+        int64_t t = m_current + 1;
+        while (m_slots[t % m_slots.size()].empty()) {
+            ++t;
+        }
+        return TimePoint(Duration(t * m_tick));
+    }
+
+    /**
+     * @brief call 'cb(T&&)' for each item that has expired by 'now'
+     *
+     * Items are handed back in tick order, and in the order they were
+     * added within a tick. 'cb' may add items.
+     *
+     * @return number of items expired
+     */
+    template<typename F>
+    size_t expire(TimePoint now, F&& cb)
+    {
+        int64_t target = floorTick(now);
+        size_t n = 0;
+        while (m_current < target && m_size != 0) {
+            ++m_current;
+            auto& slot = m_slots[m_current % m_slots.size()];
+            m_batch.swap(slot);
+            for (auto& [tick, item] : m_batch) {
+                if (tick > m_current) {
+                    // a later time round the wheel
+                    slot.push_back({tick, std::move(item)});
+                    continue;
+                }
+                --m_size;
+                ++n;
+                cb(std::move(item));
+            }
+            m_batch.clear();
+        }
+        if (m_size == 0) {
+            m_current = target;
+        }
+        return n;
+    }
+
+  private:
+    int64_t floorTick(TimePoint tp) const noexcept
+    {
+        return tp.time_since_epoch().count() / m_tick;
+    }
+
+    int64_t ceilTick(TimePoint tp) const noexcept
+    {
+        return (tp.time_since_epoch().count() + m_tick - 1) / m_tick;
+    }
+
+    int64_t m_tick;                     // in Duration units
+    std::vector<std::vector<std::pair<int64_t, T>>> m_slots;   // (tick, item)
+    std::vector<std::pair<int64_t, T>> m_batch{};   // slot being expired
+    int64_t m_current{};                // last tick expired
+    size_t m_size{};
+};
+
+}  // namespace syncps
+
+#endif  // SYNCPS_TIMING_WHEEL_HPP
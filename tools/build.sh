@@ -0,0 +1,7 @@
+g++ evlog-decode.cpp -o evlog-decode -O2 --std=c++17
+g++ log-analyze.cpp -o log-analyze -O2 --std=c++17 -pthread
+g++ syncps-recovery.cpp -o syncps-recovery -O2 --std=c++17 -I../syncps $(pkg-config --cflags --libs libndn-cxx) -lz
+g++ syncps-hash-bench.cpp -o syncps-hash-bench -O2 --std=c++17 -I../syncps $(pkg-config --cflags --libs libndn-cxx) -lz
+g++ syncps-codec-bench.cpp -o syncps-codec-bench -O2 --std=c++17 -I../syncps $(pkg-config --cflags --libs libndn-cxx) -lz
+g++ syncps-trie-bench.cpp -o syncps-trie-bench -O2 --std=c++17 -I../syncps $(pkg-config --cflags --libs libndn-cxx)
+g++ syncps-sign-bench.cpp -o syncps-sign-bench -O2 --std=c++17 -I../syncps $(pkg-config --cflags --libs libndn-cxx) -lz
@@ -0,0 +1,205 @@
+/*
+ * evlog-decode: turn binary event logs (see log.hpp in the harness
+ * directories) back into the CSV text log the notebook reads.
+ *
+ *   evlog-decode node.bin > node.log
+ *
+ * Each run appended to a file starts with its own header. The records
+ * of a run are written per thread so they're put back in time order
+ * (events at the same time stay in the order they were logged). Each
+ * run's output starts with the RUN_ANCHOR line the text log has.
+ */
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// must match log.hpp
+enum Type : uint16_t {
+  TEXT = 1,
+  PUBL_MSG = 2,
+  RECV_STATE = 3,
+  NODE = 4,
+  THREAD = 5,
+};
+
+struct Record
+{
+  uint64_t ns;
+  uint64_t node;
+  uint64_t seq;
+  uint32_t thread;
+  uint16_t type;
+  uint16_t len;
+};
+
+struct Header
+{
+  char magic[8];
+  uint64_t wallNs;
+  uint64_t steadyNs;
+  int32_t utcOffset;
+  uint32_t pid;
+};
+
+static_assert(sizeof(Record) == 32 && sizeof(Header) == 32, "evlog layout changed");
+const char magic[8] = {'E', 'V', 'L', 'O', 'G', '0', '1', '\n'};
+
+struct Event
+{
+  uint64_t ns;
+  uint32_t thread;
+  uint16_t type;
+  uint64_t node;
+  uint64_t seq;
+  std::string text;
+};
+
+class Run
+{
+public:
+  explicit
+  Run(const Header& h)
+    : m_header(h)
+  {
+  }
+
+  void
+  add(const Record& r, std::string text)
+  {
+    switch (r.type) {
+    case NODE:
+      m_nodes[r.node] = std::move(text);
+      break;
+    case THREAD:
+      m_threads[r.thread] = r.seq;
+      break;
+    default:
+      m_events.push_back({r.ns, r.thread, r.type, r.node, r.seq, std::move(text)});
+      break;
+    }
+  }
+
+  void
+  print(FILE* out)
+  {
+    std::stable_sort(m_events.begin(), m_events.end(),
+                     [](const Event& a, const Event& b) { return a.ns < b.ns; });
+    if (!m_events.empty()) {
+      fprintf(out, "\"%s\", \"0x%08" PRIx32 "\", \"0x%016" PRIx64 "\", \"RUN_ANCHOR::%" PRIu64
+              "::%" PRIu64 "\"\n", timestamp(m_header.steadyNs).c_str(), m_header.pid,
+              m_threads[m_events.front().thread], m_header.wallNs, m_header.steadyNs);
+    }
+    for (const auto& e : m_events) {
+      fprintf(out, "\"%s\", \"0x%08" PRIx32 "\", \"0x%016" PRIx64 "\", \"%s\"\n",
+              timestamp(e.ns).c_str(), m_header.pid, m_threads[e.thread],
+              message(e).c_str());
+    }
+  }
+
+private:
+  // local time as Boost.Log's TimeStamp prints it
+  std::string
+  timestamp(uint64_t ns) const
+  {
+    int64_t wall = int64_t(m_header.wallNs) + int64_t(ns - m_header.steadyNs) +
+                   int64_t(m_header.utcOffset) * 1000000000;
+    time_t secs = wall / 1000000000;
+    struct tm tm;
+    gmtime_r(&secs, &tm);
+    char buf[64];
+    size_t n = strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    snprintf(buf + n, sizeof(buf) - n, ".%06d", int(wall % 1000000000 / 1000));
+    return buf;
+  }
+
+  std::string
+  message(const Event& e)
+  {
+    const auto& node = m_nodes[e.node];
+    auto ns = "::" + std::to_string(e.ns);
+    switch (e.type) {
+    case PUBL_MSG:
+      return "PUBL_MSG::" + node + "::" + node + "=" + std::to_string(e.seq) + ns;
+    case RECV_STATE:
+      if (e.text.size() == sizeof(uint64_t)) {
+        // the publication's time
+        uint64_t pubNs;
+        memcpy(&pubNs, e.text.data(), sizeof(pubNs));
+        ns += "::" + std::to_string(int64_t(e.ns - pubNs));
+      }
+      return "RECV_STATE::" + node + "::" + std::to_string(e.seq) + ns;
+    default:
+      return e.text;
+    }
+  }
+
+  Header m_header;
+  std::unordered_map<uint64_t, std::string> m_nodes;
+  std::unordered_map<uint32_t, uint64_t> m_threads;
+  std::vector<Event> m_events;
+};
+
+int
+decode(const char* filename, FILE* out)
+{
+  FILE* in = fopen(filename, "rb");
+  if (in == nullptr) {
+    perror(filename);
+    return 1;
+  }
+  std::vector<Run> runs;
+  Record r;
+  while (fread(&r, sizeof(r), 1, in) == 1) {
+    if (memcmp(&r, magic, sizeof(magic)) == 0) {
+      Header h;
+      memcpy(&h, &r, sizeof(h));
+      runs.emplace_back(h);
+      continue;
+    }
+    if (runs.empty()) {
+      fprintf(stderr, "%s: not an event log\n", filename);
+      fclose(in);
+      return 1;
+    }
+    std::string text;
+    if (r.len > 0) {
+      size_t n = (r.len + sizeof(Record) - 1) / sizeof(Record);
+      std::vector<char> buf(n * sizeof(Record));
+      if (fread(buf.data(), sizeof(Record), n, in) != n) {
+        fprintf(stderr, "%s: truncated\n", filename);
+        break;
+      }
+      text.assign(buf.data(), r.len);
+    }
+    runs.back().add(r, std::move(text));
+  }
+  fclose(in);
+  for (auto& run : runs) {
+    run.print(out);
+  }
+  return 0;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  if (argc < 2) {
+    fprintf(stderr, "USAGE: %s evlog.bin ... > log.csv\n", argv[0]);
+    return 1;
+  }
+  int ret = 0;
+  for (int i = 1; i < argc; i++) {
+    ret |= decode(argv[i], stdout);
+  }
+  return ret;
+}
@@ -0,0 +1,607 @@
+/*
+ * log-analyze: work out the per run metrics results.ipynb plots from
+ * the harness logs (the CSV text logs, see initlogger in log.hpp).
+ *
+ *   log-analyze -d OUTER_LOG_DIR -n NUM_NODES -t 500,750,... -r 1,2,...
+ *               [-m] [-j jobs] [-o runs.csv] [-p publish-times.csv] LOG_PREFIX...
+ *
+ * Like process_log in the notebook it reads every *.log in
+ * OUTER_LOG_DIR/<LOG_PREFIX>-<pub timing>-<run> and joins the PUBL_MSG
+ * events to the RECV_STATE events for the same node=seq. Each run is
+ * one row of runs.csv (in the order of the arguments) with the values
+ * process_log appends to TIMING_DATA_AVG/50/75/90, SYNC_INT_DATA,
+ * SUCCESS_DATA(_50/_10), SUPPRESSION_DATA, NUM_PUBLISHED_DATA and
+ * NUM_nInInterestsData. Times are in ms. Values process_log can't work
+ * out (e.g. percentiles of a run where nothing was received) are left
+ * empty, as is interests_data of a run without NFD status reports.
+ * The time of every publication goes to publish-times.csv.
+ *
+ * With -m only the MEASURE phase of each node counts (see Phases in
+ * log.hpp): the publications and other events it logged during it, and
+ * receipts of those publications whenever they came. Logs without
+ * PHASE lines are all MEASURE. interests_data(_per_s) is left empty
+ * with -m since the NFD counters cover the whole run.
+ *
+ * interests_data is the Interests and Data NFD counted per publication,
+ * divided by 45 as in process_log (the length of a run before the
+ * windows were configurable) whatever the run's length.
+ * interests_data_per_s divides by the time the counters covered
+ * instead: the mean, over the nodes, of the time between their
+ * report-start and report-end files.
+ *
+ * Runs that don't exist are skipped with a warning. The logs of a run
+ * are mapped rather than read and runs are analysed in parallel.
+ */
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// a file mapped for as long as the run's being analysed
+class MappedFile
+{
+public:
+  explicit
+  MappedFile(const std::string& filename)
+  {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      perror(filename.c_str());
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(p);
+        m_size = st.st_size;
+      }
+    }
+    close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& o) noexcept
+    : m_data(o.m_data)
+    , m_size(o.m_size)
+  {
+    o.m_data = nullptr;
+    o.m_size = 0;
+  }
+
+  ~MappedFile()
+  {
+    if (m_data != nullptr) {
+      munmap(const_cast<char*>(m_data), m_size);
+    }
+  }
+
+  std::string_view
+  data() const
+  {
+    return {m_data, m_size};
+  }
+
+private:
+  const char* m_data = nullptr;
+  size_t m_size = 0;
+};
+
+// node=seq of a publication. The views point into the mapped logs.
+struct MsgKey
+{
+  std::string_view node;
+  std::string_view seq;
+
+  bool
+  operator==(const MsgKey& o) const
+  {
+    return node == o.node && seq == o.seq;
+  }
+};
+
+struct MsgKeyHash
+{
+  size_t
+  operator()(const MsgKey& k) const
+  {
+    std::hash<std::string_view> h;
+    return h(k.node) * 31 + h(k.seq);
+  }
+};
+
+struct RunResult
+{
+  std::string prefix;
+  int pubTiming = 0;
+  int run = 0;
+  bool found = false;
+  size_t published = 0;
+  double timingAvg = NAN;
+  double timing50 = NAN;
+  double timing75 = NAN;
+  double timing90 = NAN;
+  double syncInt = NAN;
+  double success = NAN;
+  double success50 = NAN;
+  double success10 = NAN;
+  double suppression = NAN;
+  double interestsData = NAN;
+  double interestsDataPerS = NAN;
+  std::vector<double> publishTimes;
+};
+
+// as numpy.percentile (linear interpolation) of sorted values
+double
+percentile(const std::vector<double>& v, double p)
+{
+  if (v.empty()) {
+    return NAN;
+  }
+  double pos = p / 100 * (v.size() - 1);
+  size_t lo = size_t(pos);
+  size_t hi = std::min(lo + 1, v.size() - 1);
+  return v[lo] + (v[hi] - v[lo]) * (pos - lo);
+}
+
+// ms since the epoch of "YYYY-MM-DD HH:MM:SS.ffffff" (taken as UTC as
+// the notebook does) or -1 if that's not what 'ts' is
+double
+parseTimestamp(std::string_view ts)
+{
+  static const char pattern[] = "dddd-dd-dd dd:dd:dd.dddddd";
+  if (ts.size() != sizeof(pattern) - 1) {
+    return -1;
+  }
+  for (size_t i = 0; i < ts.size(); i++) {
+    bool digit = ts[i] >= '0' && ts[i] <= '9';
+    if (pattern[i] == 'd' ? !digit : ts[i] != pattern[i]) {
+      return -1;
+    }
+  }
+  auto num = [&ts] (size_t pos, size_t len) {
+    int v = 0;
+    for (size_t i = pos; i < pos + len; i++) {
+      v = v * 10 + (ts[i] - '0');
+    }
+    return v;
+  };
+  struct tm tm = {};
+  tm.tm_year = num(0, 4) - 1900;
+  tm.tm_mon = num(5, 2) - 1;
+  tm.tm_mday = num(8, 2);
+  tm.tm_hour = num(11, 2);
+  tm.tm_min = num(14, 2);
+  tm.tm_sec = num(17, 2);
+  return std::floor(double(timegm(&tm)) * 1000 + num(20, 6) / 1000.0);
+}
+
+// the timestamp and message of a log line: "ts", "pid", "tid", "msg"
+bool
+splitLine(std::string_view line, std::string_view& ts, std::string_view& msg)
+{
+  if (line.size() < 2 || line.front() != '"') {
+    return false;
+  }
+  size_t end = line.find('"', 1);
+  if (end == std::string_view::npos) {
+    return false;
+  }
+  ts = line.substr(1, end - 1);
+  size_t pos = end;
+  for (int i = 0; i < 3; i++) {
+    pos = line.find("\", \"", pos);
+    if (pos == std::string_view::npos) {
+      return false;
+    }
+    pos += 4;
+  }
+  size_t last = line.rfind('"');
+  if (last < pos) {
+    return false;
+  }
+  msg = line.substr(pos, last - pos);
+  return true;
+}
+
+// the '::' separated fields of a message (at most 'max' of them)
+size_t
+splitFields(std::string_view msg, std::string_view* fields, size_t max)
+{
+  size_t n = 0;
+  while (n < max) {
+    size_t sep = msg.find("::");
+    fields[n++] = msg.substr(0, sep);
+    if (sep == std::string_view::npos) {
+      break;
+    }
+    msg.remove_prefix(sep + 2);
+  }
+  return n;
+}
+
+bool
+contains(std::string_view s, std::string_view what)
+{
+  return s.find(what) != std::string_view::npos;
+}
+
+std::vector<std::string>
+listDir(const std::string& dir, std::string_view prefix, std::string_view suffix)
+{
+  std::vector<std::string> names;
+  DIR* d = opendir(dir.c_str());
+  if (d == nullptr) {
+    return names;
+  }
+  while (auto e = readdir(d)) {
+    std::string_view name = e->d_name;
+    if (name.size() >= prefix.size() + suffix.size() &&
+        name.substr(0, prefix.size()) == prefix &&
+        name.substr(name.size() - suffix.size()) == suffix) {
+      names.emplace_back(name);
+    }
+  }
+  closedir(d);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// the counters in a report-{start,end}-*.status file (up to "Channels")
+std::unordered_map<std::string, long>
+readStatus(const std::string& filename)
+{
+  std::unordered_map<std::string, long> status;
+  std::ifstream in(filename);
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.find("Channels") != std::string::npos) {
+      break;
+    }
+    auto eq = line.find('=');
+    if (eq == std::string::npos) {
+      continue;
+    }
+    auto b = line.find_first_not_of(" \t");
+    status[line.substr(b, eq - b)] = strtol(line.c_str() + eq + 1, nullptr, 10);
+  }
+  return status;
+}
+
+// a file's modification time in seconds (0 if it can't be read)
+double
+modifiedAt(const std::string& filename)
+{
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0) {
+    return 0;
+  }
+  return st.st_mtim.tv_sec + st.st_mtim.tv_nsec / 1e9;
+}
+
+void
+analyze(const std::string& dir, size_t numNodes, bool measureOnly, RunResult& res)
+{
+  std::vector<MappedFile> logs;
+  for (const auto& name : listDir(dir, "", ".log")) {
+    logs.emplace_back(dir + "/" + name);
+  }
+  res.found = !logs.empty();
+  if (!res.found) {
+    return;
+  }
+  bool chronosync = contains(res.prefix, "chronosync");
+
+  std::unordered_map<MsgKey, double, MsgKeyHash> publishes;
+  std::unordered_map<MsgKey, std::vector<double>, MsgKeyHash> receives;
+  size_t syncInts = 0;
+  size_t suppressed = 0;
+  size_t sentNoRecord = 0;
+  size_t sentRecordOld = 0;
+
+  for (const auto& log : logs) {
+    std::string_view data = log.data();
+    // (before its first PHASE a node hasn't started publishing)
+    bool measuring = !measureOnly || data.find("PHASE::") == std::string_view::npos;
+    while (!data.empty()) {
+      size_t nl = data.find('\n');
+      std::string_view line = data.substr(0, nl);
+      data.remove_prefix(nl == std::string_view::npos ? data.size() : nl + 1);
+
+      std::string_view ts, msg;
+      if (!splitLine(line, ts, msg)) {
+        continue;
+      }
+      double t = parseTimestamp(ts);
+      if (t < 0) {
+        continue;
+      }
+      std::string_view m[5];
+      size_t n = splitFields(msg, m, 5);
+      // events with a steady clock stamp (see log.hpp) use that
+      if (m[0] == "PHASE" && n > 1) {
+        measuring = !measureOnly || m[1] == "MEASURE";
+        continue;
+      }
+      bool isPubl = contains(m[0], "PUBL_MSG");
+      bool isRecv = contains(m[0], "RECV_STATE");
+      if ((isPubl || isRecv) && n > 3) {
+        t = strtoull(std::string(m[3]).c_str(), nullptr, 10) / 1e6;
+      }
+
+      if (isPubl && measuring) {
+        if (n < 3) {
+          continue;
+        }
+        size_t eq = m[2].rfind('=');
+        MsgKey k = eq == std::string_view::npos ? MsgKey{m[2], {}} :
+                   MsgKey{m[2].substr(0, eq), m[2].substr(eq + 1)};
+        publishes[k] = t;
+        res.publishTimes.push_back(t);
+      }
+      if (isRecv && n >= 3) {
+        std::string_view node = m[1];
+        if (chronosync) {
+          // the session name has the node's prefix plus a timestamp
+          size_t slash = node.rfind('/');
+          node = slash == std::string_view::npos ? std::string_view() : node.substr(0, slash);
+        }
+        receives[{node, m[2]}].push_back(t);
+      }
+      if (!measuring) {
+        continue;
+      }
+      if (contains(m[0], "SEND_SYNC_INT")) {
+        syncInts++;
+      }
+      if (m[0] == "SYNC_REPLY_SUPPRESSED") {
+        suppressed++;
+      }
+      else if (m[0] == "SYNC_REPLY_SENT_NO_RECORD") {
+        sentNoRecord++;
+      }
+      else if (m[0] == "SYNC_REPLY_SENT_RECORD_OLD") {
+        sentRecordOld++;
+      }
+    }
+  }
+
+  // the hash join
+  std::vector<double> deltas;
+  std::vector<double> received;
+  size_t complete = 0;
+  for (const auto& r : receives) {
+    auto p = publishes.find(r.first);
+    if (measureOnly && p == publishes.end()) {
+      continue;
+    }
+    received.push_back(double(r.second.size()) / (numNodes - 1));
+    if (r.second.size() == numNodes - 1) {
+      complete++;
+    }
+    if (p == publishes.end()) {
+      continue;
+    }
+    for (double t : r.second) {
+      deltas.push_back(t - p->second);
+    }
+  }
+  std::sort(deltas.begin(), deltas.end());
+  std::sort(received.begin(), received.end());
+
+  res.published = publishes.size();
+  if (!deltas.empty()) {
+    double sum = 0;
+    for (double d : deltas) {
+      sum += d;
+    }
+    res.timingAvg = sum / deltas.size();
+  }
+  res.timing50 = percentile(deltas, 50);
+  res.timing75 = percentile(deltas, 75);
+  res.timing90 = percentile(deltas, 90);
+  res.success50 = percentile(received, 50);
+  res.success10 = percentile(received, 10);
+
+  // (svs.py takes no status reports when points run in parallel)
+  auto reports = listDir(dir, "report-start-", ".status");
+  long interestsData = 0;
+  double reportSeconds = 0;
+  for (const auto& name : reports) {
+    auto startFile = dir + "/" + name;
+    auto endFile = dir + "/report-end-" + name.substr(strlen("report-start-"));
+    auto start = readStatus(startFile);
+    auto end = readStatus(endFile);
+    interestsData += end["nInInterests"] - start["nInInterests"] +
+                     end["nInData"] - start["nInData"];
+    reportSeconds += modifiedAt(endFile) - modifiedAt(startFile);
+  }
+
+  if (res.published > 0) {
+    res.syncInt = double(syncInts) / res.published;
+    res.success = double(complete) / res.published;
+  }
+  if (res.published > 0 && !reports.empty() && !measureOnly) {
+    res.interestsData = double(interestsData) / (res.published * 45);
+    if (reportSeconds > 0) {
+      reportSeconds /= reports.size();
+      res.interestsDataPerS = double(interestsData) / (res.published * reportSeconds);
+    }
+  }
+  if (suppressed + sentNoRecord + sentRecordOld > 0) {
+    res.suppression = double(suppressed) / (suppressed + sentNoRecord + sentRecordOld);
+  }
+}
+
+std::vector<int>
+parseList(const char* s)
+{
+  std::vector<int> v;
+  for (char* end; *s != '\0'; s = *end == ',' ? end + 1 : end) {
+    v.push_back(strtol(s, &end, 10));
+    if (end == s) {
+      break;
+    }
+  }
+  return v;
+}
+
+void
+printValue(FILE* out, double v)
+{
+  if (std::isnan(v)) {
+    fputs(",", out);
+  }
+  else {
+    fprintf(out, ",%.17g", v);
+  }
+}
+
+void
+usage(const char* argv0)
+{
+  fprintf(stderr, "USAGE: %s -d OUTER_LOG_DIR -n NUM_NODES -t PUB_TIMINGS -r RUNS\n"
+          "       [-m] [-j jobs] [-o runs.csv] [-p publish-times.csv] LOG_PREFIX...\n", argv0);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  std::string outerDir;
+  size_t numNodes = 0;
+  std::vector<int> timings;
+  std::vector<int> runs;
+  size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+  const char* runsFile = nullptr;
+  const char* publishFile = nullptr;
+  bool measureOnly = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "d:n:t:r:mj:o:p:")) != -1) {
+    switch (opt) {
+    case 'd':
+      outerDir = optarg;
+      break;
+    case 'n':
+      numNodes = strtoul(optarg, nullptr, 10);
+      break;
+    case 't':
+      timings = parseList(optarg);
+      break;
+    case 'r':
+      runs = parseList(optarg);
+      break;
+    case 'm':
+      measureOnly = true;
+      break;
+    case 'j':
+      jobs = std::max(1ul, strtoul(optarg, nullptr, 10));
+      break;
+    case 'o':
+      runsFile = optarg;
+      break;
+    case 'p':
+      publishFile = optarg;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (outerDir.empty() || numNodes < 2 || timings.empty() || runs.empty() || optind == argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::vector<RunResult> results;
+  for (int i = optind; i < argc; i++) {
+    for (int timing : timings) {
+      for (int run : runs) {
+        RunResult r;
+        r.prefix = argv[i];
+        r.pubTiming = timing;
+        r.run = run;
+        results.push_back(std::move(r));
+      }
+    }
+  }
+
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    for (size_t i; (i = next++) < results.size();) {
+      auto& r = results[i];
+      std::string dir = outerDir + "/" + r.prefix + "-" + std::to_string(r.pubTiming) +
+                        "-" + std::to_string(r.run);
+      analyze(dir, numNodes, measureOnly, r);
+    }
+  };
+  std::vector<std::thread> workers;
+  for (size_t i = 0; i < std::min(jobs, results.size()); i++) {
+    workers.emplace_back(work);
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+
+  FILE* out = runsFile != nullptr ? fopen(runsFile, "w") : stdout;
+  FILE* pubOut = publishFile != nullptr ? fopen(publishFile, "w") : nullptr;
+  if (out == nullptr || (publishFile != nullptr && pubOut == nullptr)) {
+    perror(out == nullptr ? runsFile : publishFile);
+    return 1;
+  }
+  fputs("prefix,pub_timing,run,published,timing_avg,timing_50,timing_75,timing_90,"
+        "sync_int,success,success_50,success_10,suppression,interests_data,"
+        "interests_data_per_s\n", out);
+  if (pubOut != nullptr) {
+    fputs("prefix,pub_timing,run,t\n", pubOut);
+  }
+  for (const auto& r : results) {
+    if (!r.found) {
+      fprintf(stderr, "%s/%s-%d-%d: no logs\n", outerDir.c_str(), r.prefix.c_str(),
+              r.pubTiming, r.run);
+      continue;
+    }
+    fprintf(out, "%s,%d,%d,%zu", r.prefix.c_str(), r.pubTiming, r.run, r.published);
+    for (double v : {r.timingAvg, r.timing50, r.timing75, r.timing90, r.syncInt, r.success,
+                     r.success50, r.success10, r.suppression, r.interestsData,
+                     r.interestsDataPerS}) {
+      printValue(out, v);
+    }
+    fputs("\n", out);
+    if (pubOut != nullptr) {
+      for (double t : r.publishTimes) {
+        fprintf(pubOut, "%s,%d,%d,%.17g\n", r.prefix.c_str(), r.pubTiming, r.run, t);
+      }
+    }
+  }
+  if (out != stdout) {
+    fclose(out);
+  }
+  if (pubOut != nullptr) {
+    fclose(pubOut);
+  }
+  return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * syncps-codec-bench: size and encode/decode time of the IBLT name
+ * component by compression mode.
+ *
+ *   syncps-codec-bench [-n iterations] [-f fill[,fill...]] EXPECTED...
+ *
+ * For each IBLT(EXPECTED) and each fill (random keys inserted, default
+ * 0 and 60), the table is encoded (IBLT::encode, the component sync
+ * interests carry) with every Compression compiled into codec.hpp and
+ * decoded again (IBLT::initialize). A decode that doesn't give back the
+ * same table is reported and the exit status is 1.
+ *
+ * Encodes start from a fresh copy of the table, as encode() caches its
+ * result; the time to copy it is measured separately and subtracted.
+ * The output has a line per table, fill and mode: the component's
+ * value size and the us per encode and per decode.
+ *
+ * Needs ndn-cxx and the syncps headers (see build.sh).
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "iblt.hpp"
+
+namespace {
+
+using syncps::Compression;
+using syncps::IBLT;
+
+volatile size_t sink;
+
+template<typename F>
+double
+usPerOp(size_t n, F&& op)
+{
+  auto start = std::chrono::steady_clock::now();
+  size_t acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += op();
+  }
+  sink = acc;
+  std::chrono::duration<double, std::micro> t = std::chrono::steady_clock::now() - start;
+  return t.count() / n;
+}
+
+std::vector<size_t>
+parseList(const char* s)
+{
+  std::vector<size_t> v;
+  char* end;
+  do {
+    v.push_back(strtoul(s, &end, 10));
+    s = end + 1;
+  } while (*end == ',');
+  return v;
+}
+
+void
+usage(const char* argv0)
+{
+  fprintf(stderr, "USAGE: %s [-n iterations] [-f fill[,fill...]] EXPECTED...\n", argv0);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  size_t n = 20000;
+  std::vector<size_t> fills{0, 60};
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:f:")) != -1) {
+    switch (opt) {
+    case 'n':
+      n = std::max(1ul, strtoul(optarg, nullptr, 10));
+      break;
+    case 'f':
+      fills = parseList(optarg);
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind == argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::mt19937 rng(1);
+  size_t mismatches = 0;
+  printf("expected,cells,fill,compression,bytes,encode_us,decode_us\n");
+  for (int arg = optind; arg < argc; arg++) {
+    size_t expected = strtoul(argv[arg], nullptr, 10);
+    for (auto fill : fills) {
+      IBLT table(expected);
+      for (size_t i = 0; i < fill; i++) {
+        table.insert(rng());
+      }
+      for (auto c : {Compression::none, Compression::zlib, Compression::zstd,
+                     Compression::lz4}) {
+        if (! syncps::isSupported(c)) {
+          continue;
+        }
+        table.setCompression(c);
+        auto copyUs = usPerOp(n, [&] { IBLT t(table); return t.size(); });
+        auto encodeUs = usPerOp(n, [&] {
+          IBLT t(table);
+          return t.encode().value_size();
+        }) - copyUs;
+        auto component = table.encode();
+        IBLT decoded(expected);
+        auto decodeUs = usPerOp(n, [&] {
+          decoded.initialize(component);
+          return decoded.size();
+        });
+        if (decoded != table) {
+          fprintf(stderr, "IBLT(%zu) with %zu entries didn't survive %s\n",
+                  expected, fill, syncps::toString(c));
+          mismatches++;
+        }
+        printf("%zu,%zu,%zu,%s,%zu,%.2f,%.2f\n", expected, table.size(), fill,
+               syncps::toString(c), component.value_size(), encodeUs, decodeUs);
+      }
+    }
+  }
+  return mismatches == 0 ? 0 : 1;
+}
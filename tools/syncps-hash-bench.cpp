@@ -0,0 +1,236 @@
+/*
+ * syncps-hash-bench: time the murmurHash3 overloads and IBLT inserts
+ * syncps uses for publications and IBLT keys.
+ *
+ *   syncps-hash-bench [-n iterations] [-c checks]
+ *
+ * Each hash is timed against the implementation before the
+ * pointer+length primitive (refHash below: the input copied into a
+ * vector, as the 32-bit key and string overloads used to do). 'checks'
+ * random inputs (32-bit keys and buffers of 0 to 64 bytes) are hashed
+ * both ways first; any mismatch is reported and the exit status is 1.
+ *
+ * Then, per hash: 32-bit keys, and buffers the size of a small
+ * publication's wire encoding (100 bytes), a full one (1300, maxPubSize)
+ * and an IBLT name component (1549, an empty IBLT(85) without
+ * compression). Last, inserts of random keys into an IBLT(85) (erasing
+ * them again so the table stays the same size) against the same
+ * insert done as before (each sub-table's cell index and key check
+ * hashed from a vector copy of the key). The output has a line per
+ * case with the ns per operation each way.
+ *
+ * Needs ndn-cxx and the syncps headers (see build.sh).
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <unistd.h>
+
+#include "iblt.hpp"
+
+namespace {
+
+using syncps::IBLT;
+using syncps::murmurHash3;
+
+// murmurHash3 as it was: the overloads copied their input into a vector
+uint32_t
+refHash(uint32_t seed, const std::vector<unsigned char>& v)
+{
+  uint32_t h1 = seed;
+  const uint32_t c1 = 0xcc9e2d51;
+  const uint32_t c2 = 0x1b873593;
+  const size_t nblocks = v.size() / 4;
+  const uint32_t* blocks = (const uint32_t*)(&v[0] + nblocks * 4);
+
+  for (size_t i = -nblocks; i; i++) {
+    uint32_t k1 = blocks[i];
+    k1 *= c1;
+    k1 = syncps::ROTL32(k1, 15);
+    k1 *= c2;
+    h1 ^= k1;
+    h1 = syncps::ROTL32(h1, 13);
+    h1 = h1 * 5 + 0xe6546b64;
+  }
+
+  const uint8_t* tail = (const uint8_t*)(&v[0] + nblocks * 4);
+  uint32_t k1 = 0;
+  switch (v.size() & 3) {
+  case 3:
+    k1 ^= tail[2] << 16;
+    [[fallthrough]];
+  case 2:
+    k1 ^= tail[1] << 8;
+    [[fallthrough]];
+  case 1:
+    k1 ^= tail[0];
+    k1 *= c1;
+    k1 = syncps::ROTL32(k1, 15);
+    k1 *= c2;
+    h1 ^= k1;
+  }
+  h1 ^= v.size();
+  h1 ^= h1 >> 16;
+  h1 *= 0x85ebca6b;
+  h1 ^= h1 >> 13;
+  h1 *= 0xc2b2ae35;
+  h1 ^= h1 >> 16;
+  return h1;
+}
+
+uint32_t
+refHash(uint32_t seed, uint32_t key)
+{
+  return refHash(seed, std::vector<unsigned char>((unsigned char*)&key,
+                                                  (unsigned char*)&key + sizeof(key)));
+}
+
+uint32_t
+refHash(uint32_t seed, const uint8_t* data, size_t len)
+{
+  return refHash(seed, std::vector<unsigned char>(data, data + len));
+}
+
+// IBLT::update as it was, on a table of the same shape
+class RefIblt
+{
+public:
+  explicit RefIblt(size_t cells)
+    : m_table(cells)
+  {
+  }
+
+  void
+  update(int plusOrMinus, uint32_t key)
+  {
+    size_t bucketsPerHash = m_table.size() / syncps::N_HASH;
+    for (size_t i = 0; i < syncps::N_HASH; i++) {
+      auto& entry = m_table.at(i * bucketsPerHash + refHash(i, key) % bucketsPerHash);
+      entry.count += plusOrMinus;
+      entry.keySum ^= key;
+      entry.keyCheck ^= refHash(syncps::N_HASHCHECK, key);
+    }
+  }
+
+private:
+  std::vector<syncps::HashTableEntry> m_table;
+};
+
+volatile uint32_t sink;
+
+template<typename F>
+double
+nsPerOp(size_t n, F&& op)
+{
+  auto start = std::chrono::steady_clock::now();
+  uint32_t acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += op(i);
+  }
+  sink = acc;
+  std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+  return t.count() / n;
+}
+
+size_t
+check(std::mt19937& rng, size_t checks)
+{
+  size_t mismatches = 0;
+  std::vector<uint8_t> buf(64);
+  for (size_t i = 0; i < checks; i++) {
+    uint32_t seed = rng() % 16;
+    uint32_t key = rng();
+    if (murmurHash3(seed, key) != refHash(seed, key)) {
+      mismatches++;
+    }
+    size_t len = rng() % (buf.size() + 1);
+    for (size_t j = 0; j < len; j++) {
+      buf[j] = rng();
+    }
+    if (murmurHash3(seed, buf.data(), len) != refHash(seed, buf.data(), len)) {
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+void
+usage(const char* argv0)
+{
+  fprintf(stderr, "USAGE: %s [-n iterations] [-c checks]\n", argv0);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  size_t n = 2000000;
+  size_t checks = 200000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:c:")) != -1) {
+    switch (opt) {
+    case 'n':
+      n = std::max(1ul, strtoul(optarg, nullptr, 10));
+      break;
+    case 'c':
+      checks = strtoul(optarg, nullptr, 10);
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::mt19937 rng(1);
+  auto mismatches = check(rng, checks);
+  fprintf(stderr, "%zu inputs checked, %zu mismatches\n", checks * 2, mismatches);
+
+  std::vector<uint32_t> keys(4096);
+  for (auto& k : keys) {
+    k = rng();
+  }
+  const size_t mask = keys.size() - 1;
+
+  printf("case,ns,ref_ns\n");
+  printf("key,%.1f,%.1f\n",
+         nsPerOp(n, [&](size_t i) { return murmurHash3(syncps::N_HASHCHECK, keys[i & mask]); }),
+         nsPerOp(n, [&](size_t i) { return refHash(syncps::N_HASHCHECK, keys[i & mask]); }));
+
+  for (size_t len : {100, 1300, 1549}) {
+    std::vector<uint8_t> buf(len + 1);
+    for (auto& b : buf) {
+      b = rng();
+    }
+    // from an odd address, as in a wire encoding
+    const uint8_t* p = buf.data() + 1;
+    size_t m = std::max<size_t>(1, n * 16 / len);
+    printf("buf%zu,%.1f,%.1f\n", len,
+           nsPerOp(m, [&](size_t i) { return murmurHash3(i & 15, p, len); }),
+           nsPerOp(m, [&](size_t i) { return refHash(i & 15, p, len); }));
+  }
+
+  IBLT iblt(85);
+  RefIblt ref(iblt.size());
+  auto insertNs = nsPerOp(n, [&](size_t i) {
+    auto k = keys[(i >> 1) & mask];
+    if (i & 1) {
+      iblt.erase(k);
+    } else {
+      iblt.insert(k);
+    }
+    return k;
+  });
+  auto refInsertNs = nsPerOp(n, [&](size_t i) {
+    auto k = keys[(i >> 1) & mask];
+    ref.update(i & 1 ? -1 : 1, k);
+    return k;
+  });
+  printf("iblt85_insert,%.1f,%.1f\n", insertNs, refInsertNs);
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,313 @@
+/*
+ * syncps-recovery: how long two syncps peers take to reconcile after a
+ * partition, by size of the set difference it left.
+ *
+ *   syncps-recovery [-e expected_entries] [-a max_entries] [-c common]
+ *                   [-b pub_bytes] [-r rtt_ms] [-t trials] [-s] DIFF...
+ *
+ * Each trial runs two SyncPubsub (syncps.hpp) on DummyClientFaces in
+ * virtual time (ndn-cxx's unit test clocks). Both publish 'common'
+ * identical publications and, while partitioned (the packets their
+ * faces send are dropped), DIFF more split between them, of pub_bytes
+ * content each. Then the link comes up: the peers' current sync
+ * interests and everything the faces send from then on reach the other
+ * face rtt_ms/2 later. The trial ends when both have every publication
+ * or, as unanswered publications stop being sent at maxPubLifetime,
+ * just before that.
+ *
+ * -e is the IBLT's expected entries, -a turns on adaptive sizing up to
+ * max_entries (setAdaptiveIbltSize) and -s segmented replies
+ * (setSegmentedReplies). The output has a line per DIFF: the fraction
+ * of trials that reconciled, the time they took in round trips (mean,
+ * 90th percentile and max), the fraction done within two round trips
+ * and, per trial, the strata estimates and recovery interests (see
+ * SyncPubsub::recover) of the two peers.
+ *
+ * Needs ndn-cxx and the syncps headers (see build.sh).
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <ndn-cxx/util/dummy-client-face.hpp>
+#include <ndn-cxx/util/time-custom-clock.hpp>
+#include <ndn-cxx/util/time-unit-test-clock.hpp>
+
+#include "syncps.hpp"
+
+namespace {
+
+using namespace ndn::time_literals;
+using ndn::util::DummyClientFace;
+
+constexpr ndn::time::milliseconds tick = 1_ms;
+
+struct Options
+{
+  size_t expectedEntries = 85;
+  size_t maxEntries = 0;
+  size_t common = 500;
+  size_t pubBytes = 200;
+  ndn::time::milliseconds rtt = 50_ms;
+  bool segmented = false;
+};
+
+// a packet on its way to the other face
+struct InFlight
+{
+  ndn::time::steady_clock::TimePoint due;
+  DummyClientFace* to;
+  std::shared_ptr<ndn::Interest> interest;
+  std::shared_ptr<ndn::Data> data;
+};
+
+class Peer
+{
+public:
+  Peer(boost::asio::io_service& io, const Options& o)
+    : face(io, {true, true})
+    , sync(face, "/sync", [](auto&) { return false; },
+           [](auto& ours, auto& others) {
+             ours.insert(ours.end(), others.begin(), others.end());
+             return ours;
+           },
+           4_s, o.expectedEntries)
+  {
+    if (o.maxEntries > o.expectedEntries) {
+      sync.setAdaptiveIbltSize(o.maxEntries);
+    }
+    sync.setSegmentedReplies(o.segmented);
+    sync.subscribeTo("/pub", [this](auto&) { ++pubs; });
+  }
+
+  void
+  publish(const ndn::Name& name, const std::string& content)
+  {
+    syncps::Publication pub(name);
+    pub.setContent(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+    sync.publish(std::move(pub));
+    ++pubs;
+  }
+
+  // sync packets the face sent (not its prefix registrations)
+  template<typename P>
+  static std::vector<std::shared_ptr<P>>
+  take(std::vector<P>& sent)
+  {
+    std::vector<std::shared_ptr<P>> v;
+    for (auto& p : sent) {
+      if (! ndn::Name("/localhost").isPrefixOf(p.getName())) {
+        v.push_back(std::make_shared<P>(p));
+      }
+    }
+    sent.clear();
+    return v;
+  }
+
+  DummyClientFace face;
+  syncps::SyncPubsub sync;
+  size_t pubs = 0;
+};
+
+struct Trial
+{
+  bool reconciled = false;
+  double roundTrips = 0;
+  size_t estimates = 0;
+  size_t recoveryInterests = 0;
+};
+
+class Clocks
+{
+public:
+  Clocks()
+    : m_steady(std::make_shared<ndn::time::UnitTestSteadyClock>())
+    , m_system(std::make_shared<ndn::time::UnitTestSystemClock>())
+  {
+    ndn::time::setCustomClocks(m_steady, m_system);
+  }
+
+  ~Clocks()
+  {
+    ndn::time::setCustomClocks(nullptr, nullptr);
+  }
+
+  void
+  advance(boost::asio::io_service& io, ndn::time::nanoseconds d)
+  {
+    m_steady->advance(d);
+    m_system->advance(d);
+    if (io.stopped()) {
+      io.restart();
+    }
+    io.poll();
+  }
+
+private:
+  std::shared_ptr<ndn::time::UnitTestSteadyClock> m_steady;
+  std::shared_ptr<ndn::time::UnitTestSystemClock> m_system;
+};
+
+Trial
+runTrial(Clocks& clocks, size_t trial, size_t diff, const Options& o)
+{
+  boost::asio::io_service io;
+  Peer a(io, o);
+  Peer b(io, o);
+  clocks.advance(io, tick);
+
+  // partitioned
+  std::string content(o.pubBytes, 'x');
+  for (size_t i = 0; i < o.common; i++) {
+    auto name = ndn::Name("/pub/common").appendNumber(trial).appendNumber(i);
+    a.publish(name, content);
+    b.publish(name, content);
+  }
+  for (size_t i = 0; i < diff; i++) {
+    auto& p = i % 2 == 0 ? a : b;
+    p.publish(ndn::Name("/pub").append(&p == &a ? "a" : "b").appendNumber(trial).appendNumber(i),
+              content);
+  }
+  clocks.advance(io, tick);
+  auto published = ndn::time::steady_clock::now();
+  auto total = o.common + diff;
+
+  // the link comes up with the peers' current sync interests
+  std::deque<InFlight> inFlight;
+  auto send = [&](Peer& from, Peer& to) {
+    auto due = ndn::time::steady_clock::now() + o.rtt / 2;
+    for (auto& i : Peer::take(from.face.sentInterests)) {
+      inFlight.push_back({due, &to.face, std::move(i), nullptr});
+    }
+    for (auto& d : Peer::take(from.face.sentData)) {
+      inFlight.push_back({due, &to.face, nullptr, std::move(d)});
+    }
+  };
+  for (auto* p : {&a, &b}) {
+    auto sent = Peer::take(p->face.sentInterests);
+    p->face.sentData.clear();
+    if (! sent.empty()) {
+      p->face.sentInterests.push_back(*sent.back());
+    }
+  }
+  auto start = ndn::time::steady_clock::now();
+  auto end = published + syncps::maxPubLifetime - tick;
+  while (ndn::time::steady_clock::now() < end && (a.pubs < total || b.pubs < total)) {
+    send(a, b);
+    send(b, a);
+    clocks.advance(io, tick);
+    auto now = ndn::time::steady_clock::now();
+    while (! inFlight.empty() && inFlight.front().due <= now) {
+      auto f = std::move(inFlight.front());
+      inFlight.pop_front();
+      if (f.interest) {
+        f.to->receive(*f.interest);
+      } else {
+        f.to->receive(*f.data);
+      }
+    }
+    io.poll();
+  }
+
+  Trial t;
+  t.reconciled = a.pubs == total && b.pubs == total;
+  t.roundTrips = double((ndn::time::steady_clock::now() - start).count()) /
+                 ndn::time::nanoseconds(o.rtt).count();
+  for (auto* p : {&a, &b}) {
+    t.estimates += p->sync.getCounters().strataEstimates;
+    t.recoveryInterests += p->sync.getCounters().recoveryInterests;
+  }
+  return t;
+}
+
+void
+usage(const char* argv0)
+{
+  fprintf(stderr, "USAGE: %s [-e expected_entries] [-a max_entries] [-c common] [-b pub_bytes]\n"
+          "       [-r rtt_ms] [-t trials] [-s] DIFF...\n", argv0);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  Options o;
+  size_t trials = 20;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "e:a:c:b:r:t:s")) != -1) {
+    switch (opt) {
+    case 'e':
+      o.expectedEntries = strtoul(optarg, nullptr, 10);
+      break;
+    case 'a':
+      o.maxEntries = strtoul(optarg, nullptr, 10);
+      break;
+    case 'c':
+      o.common = strtoul(optarg, nullptr, 10);
+      break;
+    case 'b':
+      o.pubBytes = std::max(1ul, strtoul(optarg, nullptr, 10));
+      break;
+    case 'r':
+      o.rtt = ndn::time::milliseconds(std::max(2ul, strtoul(optarg, nullptr, 10)));
+      break;
+    case 't':
+      trials = std::max(1ul, strtoul(optarg, nullptr, 10));
+      break;
+    case 's':
+      o.segmented = true;
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind == argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  Clocks clocks;
+  size_t trial = 0;
+  printf("diff,reconciled,rtts_avg,rtts_90,rtts_max,within_2rtts,estimates_avg,"
+         "recovery_interests_avg\n");
+  for (int arg = optind; arg < argc; arg++) {
+    size_t diff = strtoul(argv[arg], nullptr, 10);
+    std::vector<double> rtts;
+    size_t estimates = 0, recoveryInterests = 0;
+    for (size_t i = 0; i < trials; i++) {
+      auto t = runTrial(clocks, trial++, diff, o);
+      if (t.reconciled) {
+        rtts.push_back(t.roundTrips);
+      }
+      estimates += t.estimates;
+      recoveryInterests += t.recoveryInterests;
+    }
+    printf("%zu,%.2f,", diff, double(rtts.size()) / trials);
+    if (rtts.empty()) {
+      printf(",,,0");
+    } else {
+      std::sort(rtts.begin(), rtts.end());
+      double sum = 0;
+      for (auto r : rtts) {
+        sum += r;
+      }
+      auto within = std::upper_bound(rtts.begin(), rtts.end(), 2.0) - rtts.begin();
+      printf("%.2f,%.2f,%.2f,%.2f", sum / rtts.size(),
+             rtts[std::min(rtts.size() - 1, size_t(std::ceil(rtts.size() * 0.9)) - 1)],
+             rtts.back(), double(within) / trials);
+    }
+    printf(",%.2f,%.2f\n", double(estimates) / trials, double(recoveryInterests) / trials);
+  }
+  return 0;
+}
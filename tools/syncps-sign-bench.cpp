@@ -0,0 +1,144 @@
+/*
+ * syncps-sign-bench: signing throughput of syncps' Signer backends
+ * (signer.hpp) by batch size.
+ *
+ *   syncps-sign-bench [-d data_per_point] [-b content_bytes] [-k] BATCH...
+ *
+ * Per BATCH, batches of that many Data of content_bytes content each
+ * (as the segments of a reply) are signed with KeyChainSigner (a
+ * signature per Data) and with MerkleSigner (one per batch, see
+ * MerkleSigner::sign) until data_per_point Data have been signed. Each
+ * Merkle signed Data's root is then recomputed (MerkleSigner::rootOf)
+ * and compared across the batch; a batch whose roots differ is
+ * reported and the exit status is 1.
+ *
+ * Signing uses a SHA256 digest, as SyncPubsub does by default, or with
+ * -k the KeyChain's default identity, which is where batching pays off.
+ * The output has a line per signer and BATCH: us per batch, us per Data
+ * and Data signed per second.
+ *
+ * Needs ndn-cxx and the syncps headers (see build.sh).
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <ndn-cxx/data.hpp>
+#include <ndn-cxx/security/key-chain.hpp>
+#include <ndn-cxx/security/signing-info.hpp>
+
+#include "signer.hpp"
+
+namespace {
+
+using syncps::DataBatch;
+using syncps::MerkleSigner;
+
+DataBatch
+makeBatch(size_t size, size_t contentBytes)
+{
+  std::string content(contentBytes, 'x');
+  DataBatch batch;
+  for (size_t i = 0; i < size; i++) {
+    auto d = std::make_shared<ndn::Data>(ndn::Name("/sync/reply").appendSegment(i));
+    d->setContent(reinterpret_cast<const uint8_t*>(content.data()), content.size());
+    batch.push_back(std::move(d));
+  }
+  return batch;
+}
+
+// us per batch signed
+double
+timeSigner(syncps::Signer& signer, const DataBatch& batch, size_t batches,
+           const ndn::security::SigningInfo& info)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < batches; i++) {
+    signer.sign(batch, info);
+  }
+  std::chrono::duration<double, std::micro> t = std::chrono::steady_clock::now() - start;
+  return t.count() / batches;
+}
+
+bool
+rootsAgree(const DataBatch& batch)
+{
+  if (batch.size() < 2) {
+    return true;
+  }
+  std::optional<MerkleSigner::Digest> root;
+  for (const auto& d : batch) {
+    auto r = MerkleSigner::rootOf(*d);
+    if (! r || (root && r->first != *root)) {
+      return false;
+    }
+    root = r->first;
+  }
+  return true;
+}
+
+void
+usage(const char* argv0)
+{
+  fprintf(stderr, "USAGE: %s [-d data_per_point] [-b content_bytes] [-k] BATCH...\n", argv0);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  size_t dataPerPoint = 20000;
+  size_t contentBytes = 1300;
+  auto info = ndn::security::SigningInfo(ndn::security::SigningInfo::SIGNER_TYPE_SHA256);
+
+  int opt;
+  while ((opt = getopt(argc, argv, "d:b:k")) != -1) {
+    switch (opt) {
+    case 'd':
+      dataPerPoint = std::max(1ul, strtoul(optarg, nullptr, 10));
+      break;
+    case 'b':
+      contentBytes = strtoul(optarg, nullptr, 10);
+      break;
+    case 'k':
+      info = ndn::security::SigningInfo();
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind == argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  ndn::KeyChain keyChain;
+  syncps::KeyChainSigner perData(keyChain);
+  MerkleSigner merkle(keyChain);
+  size_t mismatches = 0;
+
+  printf("signer,batch,us_per_batch,us_per_data,data_per_s\n");
+  for (int arg = optind; arg < argc; arg++) {
+    size_t size = std::max(1ul, strtoul(argv[arg], nullptr, 10));
+    auto batch = makeBatch(size, contentBytes);
+    size_t batches = std::max(1ul, dataPerPoint / size);
+    for (auto [name, signer] : {std::make_pair("keychain", (syncps::Signer*)&perData),
+                                std::make_pair("merkle", (syncps::Signer*)&merkle)}) {
+      auto us = timeSigner(*signer, batch, batches, info);
+      printf("%s,%zu,%.2f,%.2f,%.0f\n", name, size, us, us / size, size * 1e6 / us);
+    }
+    if (! rootsAgree(batch)) {
+      fprintf(stderr, "batch of %zu: Merkle roots differ\n", size);
+      mismatches++;
+    }
+  }
+  return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+/*
+ * syncps-trie-bench: time syncps' subscription dispatch (NameTrie's
+ * longest prefix match) by number of subscriptions.
+ *
+ *   syncps-trie-bench [-n lookups] [-c checks] SUBSCRIPTIONS...
+ *
+ * First 'checks' random inserts, erases and lookups on a NameTrie
+ * (name-trie.hpp) of short names over a few components are checked
+ * against a brute force longest prefix match; any mismatch is reported
+ * and the exit status is 1.
+ *
+ * Then, per SUBSCRIPTIONS, that many 3-component topics are
+ * subscribed and 5-component publication names under them (plus 1 in 8
+ * under no topic) are dispatched, as onValidData does. Each dispatch is
+ * timed against the std::map lower_bound/isPrefixOf lookup used before
+ * the trie. The output has a line per SUBSCRIPTIONS with the ns per
+ * dispatch each way.
+ *
+ * Needs ndn-cxx and the syncps headers (see build.sh).
+ */
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <unistd.h>
+
+#include <ndn-cxx/name.hpp>
+
+#include "name-trie.hpp"
+
+namespace {
+
+using syncps::NameTrie;
+
+volatile size_t sink;
+
+template<typename F>
+double
+nsPerOp(size_t n, F&& op)
+{
+  auto start = std::chrono::steady_clock::now();
+  size_t acc = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += op(i);
+  }
+  sink = acc;
+  std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+  return t.count() / n;
+}
+
+// the dispatch before NameTrie
+const size_t*
+mapMatch(const std::map<ndn::Name, size_t>& subs, const ndn::Name& nm)
+{
+  auto sub = subs.lower_bound(nm);
+  if ((sub != subs.end() && sub->first.isPrefixOf(nm)) ||
+      (sub != subs.begin() && (--sub)->first.isPrefixOf(nm))) {
+    return &sub->second;
+  }
+  return nullptr;
+}
+
+// components from a small alphabet so prefixes collide often
+ndn::Name
+randomName(std::mt19937& rng, size_t maxLen)
+{
+  ndn::Name n;
+  for (size_t i = rng() % (maxLen + 1); i > 0; i--) {
+    n.append(std::string(1, char('a' + rng() % 3)));
+  }
+  return n;
+}
+
+size_t
+check(std::mt19937& rng, size_t checks)
+{
+  NameTrie<size_t> trie;
+  std::map<ndn::Name, size_t> ref;
+  size_t mismatches = 0;
+  for (size_t i = 0; i < checks; i++) {
+    auto name = randomName(rng, 4);
+    switch (rng() % 3) {
+    case 0:
+      trie.insert(name, i);
+      ref[name] = i;
+      break;
+    case 1:
+      if (trie.erase(name) != (ref.erase(name) != 0)) {
+        mismatches++;
+      }
+      break;
+    default: {
+      const std::pair<const ndn::Name, size_t>* best = nullptr;
+      for (const auto& e : ref) {
+        if (e.first.isPrefixOf(name) && (! best || e.first.size() > best->first.size())) {
+          best = &e;
+        }
+      }
+      auto m = trie.longestPrefixMatch(name);
+      if (best ? (! m.value || *m.value != best->second || m.length != best->first.size())
+               : m.value != nullptr) {
+        mismatches++;
+      }
+    }
+    }
+    if (trie.size() != ref.size()) {
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+void
+usage(const char* argv0)
+{
+  fprintf(stderr, "USAGE: %s [-n lookups] [-c checks] SUBSCRIPTIONS...\n", argv0);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  size_t n = 2000000;
+  size_t checks = 20000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:c:")) != -1) {
+    switch (opt) {
+    case 'n':
+      n = std::max(1ul, strtoul(optarg, nullptr, 10));
+      break;
+    case 'c':
+      checks = strtoul(optarg, nullptr, 10);
+      break;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (optind == argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::mt19937 rng(1);
+  auto mismatches = check(rng, checks);
+  fprintf(stderr, "%zu operations checked, %zu mismatches\n", checks, mismatches);
+
+  printf("subscriptions,ns,ref_ns\n");
+  for (int arg = optind; arg < argc; arg++) {
+    size_t nsubs = std::max(1ul, strtoul(argv[arg], nullptr, 10));
+    NameTrie<size_t> trie;
+    std::map<ndn::Name, size_t> subs;
+    std::vector<ndn::Name> topics;
+    for (size_t i = 0; i < nsubs; i++) {
+      auto topic = ndn::Name("/topic").appendNumber(i / 64).appendNumber(i);
+      trie.insert(topic, i);
+      subs[topic] = i;
+      topics.push_back(topic);
+    }
+    std::vector<ndn::Name> names(4096);
+    for (auto& nm : names) {
+      nm = rng() % 8 == 0 ? ndn::Name("/other").appendNumber(rng()).appendNumber(rng())
+                          : topics[rng() % nsubs];
+      nm.append("pub").appendNumber(rng());
+    }
+    const size_t mask = names.size() - 1;
+    auto trieNs = nsPerOp(n, [&](size_t i) {
+      auto m = trie.longestPrefixMatch(names[i & mask]);
+      return m.value ? *m.value : 0;
+    });
+    auto mapNs = nsPerOp(n, [&](size_t i) {
+      auto v = mapMatch(subs, names[i & mask]);
+      return v ? *v : 0;
+    });
+    printf("%zu,%.1f,%.1f\n", nsubs, trieNs, mapNs);
+  }
+  return mismatches == 0 ? 0 : 1;
+}